@@ -0,0 +1,60 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "benchmark_utils.h"
+// Available after a CMake build
+#include "photog_average.h"
+
+/** Measures how photog_average scales from one thread to all hardware threads
+ * on a 24 MP image and checks that every thread count gives bit-identical
+ * averages.*/
+int main() {
+    const int width{6000}, height{4000}, channels{3};
+    std::vector<float> storage;
+    Halide::Runtime::Buffer<float> input =
+            photog::random_image(storage, width, height, channels);
+    Halide::Runtime::Buffer<float> reference{channels};
+    Halide::Runtime::Buffer<float> output{channels};
+
+    halide_set_num_threads(1);
+    photog_average(input, reference);
+
+    std::cout << "photog_average " << width << "x" << height << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms"
+              << std::setw(12) << "MP/s" << std::setw(12) << "speedup"
+              << std::setw(16) << "bit-identical" << std::endl;
+
+    double single_thread_seconds{0};
+    bool all_identical{true};
+    for (int threads : photog::thread_counts()) {
+        halide_set_num_threads(threads);
+        double seconds = Halide::Tools::benchmark(10, 5, [&]() {
+            photog_average(input, output);
+        });
+
+        if (threads == 1)
+            single_thread_seconds = seconds;
+
+        bool identical{true};
+        for (int c = 0; c < channels; ++c)
+            identical = identical && output(c) == reference(c);
+        all_identical = all_identical && identical;
+
+        std::cout << std::setw(8) << threads
+                  << std::setw(12) << std::fixed << std::setprecision(3)
+                  << seconds * 1e3
+                  << std::setw(12) << std::setprecision(1)
+                  << photog::megapixels_per_second(width, height, seconds)
+                  << std::setw(12) << std::setprecision(2)
+                  << single_thread_seconds / seconds
+                  << std::setw(16) << (identical ? "yes" : "no") << std::endl;
+    }
+
+    halide_set_num_threads(0); // Restore Halide's default
+
+    return all_identical ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+
+/** Compares images per second of photog_chromadapt_batch against calling
+ * photog_chromadapt once per image, for a batch of thumbnails where fixed
+ * per-call overhead dominates.*/
+int main() {
+    const int count{256}, channels{3};
+    // Thumbnails alternate between landscape and portrait.
+    const int sizes[][2]{{500, 500},
+                         {512, 384},
+                         {384, 512}};
+
+    std::vector<std::vector<float>> input_storage(count);
+    std::vector<std::vector<float>> output_storage(count);
+    std::vector<PhotogImage> inputs, outputs;
+    for (int i = 0; i < count; ++i) {
+        const int width{sizes[i % 3][0]}, height{sizes[i % 3][1]};
+        photog::random_image(input_storage[i], width, height, channels);
+        output_storage[i].resize(input_storage[i].size());
+        inputs.push_back(photog_make_image(input_storage[i].data(), Float32,
+                                           width, height,
+                                           PhotogLayout::Planar));
+        outputs.push_back(photog_make_image(output_storage[i].data(), Float32,
+                                            width, height,
+                                            PhotogLayout::Planar));
+    }
+
+    double loop_seconds = Halide::Tools::benchmark(5, 1, [&]() {
+        for (int i = 0; i < count; ++i)
+            photog_chromadapt_image(&inputs[i], PhotogWorkingSpace::Srgb,
+                                    PhotogChromadaptMethod::Bradford,
+                                    PhotogIlluminant::D50,
+                                    PhotogAccuracy::Exact, &outputs[i]);
+    });
+    double batch_seconds = Halide::Tools::benchmark(5, 1, [&]() {
+        photog_chromadapt_batch(inputs.data(), count,
+                                PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                PhotogIlluminant::D50, PhotogAccuracy::Exact,
+                                outputs.data());
+    });
+
+    std::cout << count << " thumbnails" << std::endl;
+    std::cout << std::setw(10) << "path" << std::setw(12) << "ms"
+              << std::setw(14) << "images/s" << std::endl;
+    std::cout << std::setw(10) << "loop" << std::setw(12) << std::fixed
+              << std::setprecision(3) << loop_seconds * 1e3
+              << std::setw(14) << std::setprecision(1)
+              << count / loop_seconds << std::endl;
+    std::cout << std::setw(10) << "batch" << std::setw(12)
+              << std::setprecision(3) << batch_seconds * 1e3
+              << std::setw(14) << std::setprecision(1)
+              << count / batch_seconds << std::endl;
+    std::cout << "speedup " << std::setprecision(2)
+              << loop_seconds / batch_seconds << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef PHOTOG_BENCHMARK_UTILS_H
+#define PHOTOG_BENCHMARK_UTILS_H
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Halide.h"
+
+#include "utils.h"
+
+namespace photog {
+    /** Creates an image of uniformly-distributed values between 0 and 1 in
+     * the given layout.
+     *
+     * Values are seeded so that every run benchmarks identical input.*/
+    template<typename T>
+    Halide::Runtime::Buffer<T>
+    random_image(std::vector<T> &storage, int width, int height,
+                 int channels,
+                 PhotogLayout layout = PhotogLayout::Planar) {
+        std::mt19937 generator{42};
+        std::uniform_real_distribution<float> distribution{0.0f, 1.0f};
+        storage.resize(static_cast<size_t>(width) * height * channels);
+        for (T &value : storage)
+            value = static_cast<T>(distribution(generator));
+
+        return photog::get_buffer<T>(storage.data(), width, height, channels,
+                                     layout);
+    }
+
+    /** Thread counts from 1 to the number of hardware threads in powers of
+     * two, always ending with the number of hardware threads.*/
+    inline std::vector<int> thread_counts() {
+        int max_threads =
+                std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        std::vector<int> counts;
+        for (int threads = 1; threads < max_threads; threads *= 2)
+            counts.push_back(threads);
+        counts.push_back(max_threads);
+
+        return counts;
+    }
+
+    /** Converts a duration for processing an image to megapixels per second.*/
+    inline double megapixels_per_second(int width, int height, double seconds) {
+        return (static_cast<double>(width) * height / 1e6) / seconds;
+    }
+}
+
+#endif // PHOTOG_BENCHMARK_UTILS_H
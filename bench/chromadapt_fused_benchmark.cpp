@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+
+namespace {
+    void print_row(const std::string &path, int width, int height,
+                   double seconds, float max_difference) {
+        // An image is read and written in full at least once.
+        double image_bytes = static_cast<double>(width) * height * 3 *
+                             sizeof(float);
+        std::cout << std::setw(16) << path
+                  << std::setw(12) << std::fixed << std::setprecision(3)
+                  << seconds * 1e3
+                  << std::setw(12) << std::setprecision(1)
+                  << photog::megapixels_per_second(width, height, seconds)
+                  << std::setw(12) << std::setprecision(2)
+                  << (2 * image_bytes / 1e9) / seconds
+                  << std::setw(14) << std::setprecision(6) << max_difference
+                  << std::endl;
+    }
+
+    float max_difference(const std::vector<float> &a,
+                         const std::vector<float> &b) {
+        float difference{0};
+        for (size_t i = 0; i < a.size(); ++i)
+            difference = std::max(difference, std::abs(a[i] - b[i]));
+
+        return difference;
+    }
+}
+
+/** Compares latency and effective bandwidth of photog_chromadapt, which reads
+ * its input once to estimate and again to adapt, against
+ * photog_chromadapt_fused at several sample factors.
+ *
+ * Effective bandwidth counts one read and one write of the image, the minimum
+ * traffic for chromatic adaptation, so paths can be compared directly.*/
+int main() {
+    const int sizes[][2]{{500,  500},
+                         {3840, 2160},
+                         {6000, 4000}};
+    const int sample_factors[]{1, 4, 8};
+
+    for (const auto &size : sizes) {
+        const int width{size[0]}, height{size[1]}, channels{3};
+        std::vector<float> storage;
+        photog::random_image(storage, width, height, channels);
+        std::vector<float> reference(storage.size());
+        std::vector<float> output(storage.size());
+
+        std::cout << "photog_chromadapt " << width << "x" << height
+                  << std::endl;
+        std::cout << std::setw(16) << "path" << std::setw(12) << "ms"
+                  << std::setw(12) << "MP/s" << std::setw(12) << "GB/s"
+                  << std::setw(14) << "max diff" << std::endl;
+
+        double seconds = Halide::Tools::benchmark(5, 3, [&]() {
+            photog_chromadapt_ex(storage.data(), width, height,
+                                 PhotogLayout::Planar,
+                                 PhotogWorkingSpace::Srgb,
+                                 PhotogChromadaptMethod::Bradford,
+                                 PhotogIlluminant::D50, PhotogAccuracy::Exact,
+                                 reference.data());
+        });
+        print_row("two-call", width, height, seconds, 0.0f);
+
+        for (int sample_factor : sample_factors) {
+            seconds = Halide::Tools::benchmark(5, 3, [&]() {
+                photog_chromadapt_fused(storage.data(), width, height,
+                                        PhotogLayout::Planar,
+                                        sample_factor,
+                                        PhotogWorkingSpace::Srgb,
+                                        PhotogChromadaptMethod::Bradford,
+                                        PhotogIlluminant::D50,
+                                        PhotogAccuracy::Exact, output.data());
+            });
+            print_row("fused 1/" + std::to_string(sample_factor), width,
+                      height, seconds, max_difference(reference, output));
+        }
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
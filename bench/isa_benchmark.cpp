@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+#include "HalideRuntime.h"
+#include "halide_benchmark.h"
+
+#include "benchmark_utils.h"
+#include "photog/color.h"
+
+namespace {
+    /** An instruction set tier and the Halide features it may not use.*/
+    struct IsaTier {
+        std::string name;
+        std::vector<halide_target_feature_t> disallowed;
+    };
+
+    const std::vector<halide_target_feature_t> *disallowed_features{nullptr};
+
+    bool requests_any(int count, const uint64_t *features,
+                      const std::vector<halide_target_feature_t> &disallowed) {
+        for (halide_target_feature_t feature : disallowed) {
+            int word = feature / 64;
+            if (word < count && (features[word] >> (feature % 64)) & 1)
+                return true;
+        }
+
+        return false;
+    }
+
+    /** Rejects multitarget variants that need a disallowed feature so that
+     * the next, less capable, variant runs instead.*/
+    int can_use_tier_features(int count, const uint64_t *features) {
+        if (disallowed_features &&
+            requests_any(count, features, *disallowed_features))
+            return 0;
+
+        return halide_default_can_use_target_features(count, features);
+    }
+}
+
+/** Measures photog_chromadapt throughput with each instruction set variant
+ * photog was compiled for, by hiding CPU features from Halide's runtime
+ * dispatch. Tiers the CPU cannot run fall back to the next variant and are
+ * reported as such.*/
+int main() {
+    const std::vector<halide_target_feature_t> avx512{
+            halide_target_feature_avx512,
+            halide_target_feature_avx512_knl,
+            halide_target_feature_avx512_skylake,
+            halide_target_feature_avx512_cannonlake,
+            halide_target_feature_avx512_sapphirerapids};
+    std::vector<halide_target_feature_t> avx2{
+            halide_target_feature_avx,
+            halide_target_feature_avx2,
+            halide_target_feature_fma,
+            halide_target_feature_f16c};
+    avx2.insert(avx2.end(), avx512.begin(), avx512.end());
+
+    // The last multitarget variant runs unconditionally, so the SSE4.1 tier
+    // is reached by hiding everything above it.
+    const std::vector<IsaTier> tiers{{"avx512", {}},
+                                     {"avx2",   avx512},
+                                     {"sse41",  avx2}};
+
+    const int width{6000}, height{4000}, channels{3};
+    std::vector<float> input_storage, output_storage;
+    Halide::Runtime::Buffer<float> input =
+            photog::random_image(input_storage, width, height, channels);
+    Halide::Runtime::Buffer<float> output =
+            photog::random_image(output_storage, width, height, channels);
+
+    halide_set_custom_can_use_target_features(can_use_tier_features);
+
+    std::cout << width << "x" << height << " photog_chromadapt" << std::endl;
+    std::cout << std::setw(10) << "isa" << std::setw(12) << "ms"
+              << std::setw(12) << "MP/s" << std::setw(14) << "supported"
+              << std::endl;
+
+    for (const IsaTier &tier : tiers) {
+        disallowed_features = &tier.disallowed;
+        double seconds = Halide::Tools::benchmark(10, 3, [&]() {
+            photog_chromadapt_ex(input_storage.data(), width, height,
+                                 PhotogLayout::Planar,
+                                 PhotogWorkingSpace::Srgb,
+                                 PhotogChromadaptMethod::Bradford,
+                                 PhotogIlluminant::D65, PhotogAccuracy::Exact,
+                                 output_storage.data());
+        });
+
+        // A tier is supported if the CPU has every feature the next tier
+        // down hides.
+        const IsaTier *next = &tier + 1;
+        bool supported{true};
+        if (next != tiers.data() + tiers.size()) {
+            disallowed_features = nullptr;
+            for (halide_target_feature_t feature : next->disallowed) {
+                if (feature == halide_target_feature_avx512_knl ||
+                    feature == halide_target_feature_avx512_cannonlake ||
+                    feature == halide_target_feature_avx512_sapphirerapids)
+                    continue; // Not required by photog's default targets
+                uint64_t features[(halide_target_feature_end + 63) / 64]{};
+                features[feature / 64] |= uint64_t{1} << (feature % 64);
+                if (!halide_default_can_use_target_features(
+                        (halide_target_feature_end + 63) / 64, features))
+                    supported = false;
+            }
+        }
+
+        std::cout << std::setw(10) << tier.name << std::setw(12) << std::fixed
+                  << std::setprecision(2) << seconds * 1e3 << std::setw(12)
+                  << std::setprecision(1)
+                  << photog::megapixels_per_second(width, height, seconds)
+                  << std::setw(14) << (supported ? "yes" : "fallback")
+                  << std::endl;
+    }
+
+    disallowed_features = nullptr;
+    halide_set_custom_can_use_target_features(
+            halide_default_can_use_target_features);
+
+    return 0;
+}
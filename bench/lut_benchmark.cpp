@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+#include "color_utils.h"
+
+namespace {
+    /** Tristimulus values of the source and destination illuminants of the
+     * benchmarked adaptation.*/
+    struct Adaptation {
+        std::array<float, 3> source;
+        std::array<float, 3> dest;
+    };
+
+    /** Adapts an sRGB image from illuminant A to D65, converting it to
+     * linear RGB and XYZ and back on the way.*/
+    void adapt(void *user_context, const PhotogImage *input,
+               const PhotogImage *output) {
+        auto adaptation = static_cast<Adaptation *>(user_context);
+        photog_chromadapt_diy_image(input, adaptation->source.data(),
+                                    PhotogWorkingSpace::Srgb,
+                                    PhotogChromadaptMethod::Bradford,
+                                    adaptation->dest.data(),
+                                    PhotogAccuracy::Exact, output);
+    }
+}
+
+/** Measures throughput of a chromatic adaptation evaluated per pixel against
+ * the same adaptation baked into 33^3 and 65^3 lookup tables, and the
+ * largest error of each table, on a 1080p image in both layouts.*/
+int main() {
+    const int width{1920}, height{1080}, channels{3};
+    const int sizes[]{33, 65};
+    Adaptation adaptation{photog::get_tristimulus(PhotogIlluminant::A),
+                          photog::get_tristimulus(PhotogIlluminant::D65)};
+
+    std::cout << std::setw(12) << "layout" << std::setw(12) << "method"
+              << std::setw(10) << "MP/s" << std::setw(14) << "max error"
+              << std::endl;
+
+    for (PhotogLayout layout : {PhotogLayout::Planar,
+                                PhotogLayout::Interleaved}) {
+        std::string layout_name =
+                layout == PhotogLayout::Planar ? "planar" : "interleaved";
+        std::vector<float> input_storage, expected_storage, output_storage;
+        photog::random_image(input_storage, width, height, channels, layout);
+        expected_storage.resize(input_storage.size());
+        output_storage.resize(input_storage.size());
+        PhotogImage input = photog_make_image(input_storage.data(), Float32,
+                                              width, height, layout);
+        PhotogImage expected = photog_make_image(expected_storage.data(),
+                                                 Float32, width, height,
+                                                 layout);
+        PhotogImage output = photog_make_image(output_storage.data(), Float32,
+                                               width, height, layout);
+
+        double analytic_seconds = Halide::Tools::benchmark(5, 10, [&]() {
+            adapt(&adaptation, &input, &expected);
+        });
+        std::cout << std::setw(12) << layout_name << std::setw(12)
+                  << "analytic" << std::setw(10) << std::fixed
+                  << std::setprecision(1)
+                  << photog::megapixels_per_second(width, height,
+                                                   analytic_seconds)
+                  << std::setw(14) << "-" << std::endl;
+
+        for (int size : sizes) {
+            PhotogLut *lut = photog_lut_bake(size, adapt, &adaptation);
+            double lut_seconds = Halide::Tools::benchmark(5, 10, [&]() {
+                photog_lut_apply(lut, &input, &output);
+            });
+            photog_lut_destroy(lut);
+
+            float max_error{0};
+            for (size_t i = 0; i < output_storage.size(); ++i)
+                max_error = std::max(max_error,
+                                     std::abs(output_storage[i] -
+                                              expected_storage[i]));
+
+            std::cout << std::setw(12) << layout_name << std::setw(12)
+                      << "lut " + std::to_string(size)
+                      << std::setw(10) << std::setprecision(1)
+                      << photog::megapixels_per_second(width, height,
+                                                       lut_seconds)
+                      << std::setw(14) << std::scientific
+                      << std::setprecision(2) << max_error << std::fixed
+                      << std::endl;
+        }
+    }
+
+    return 0;
+}
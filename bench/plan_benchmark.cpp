@@ -0,0 +1,62 @@
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+
+/** Measures per-call overhead of photog_chromadapt_image, which sets up its
+ * matrices on every call, against executing a PhotogChromadaptPlan. Images
+ * are tiny so that host-side set-up dominates.*/
+int main() {
+    const int sizes[]{1, 8, 32, 64};
+    const int channels{3};
+
+    PhotogChromadaptPlan *plan =
+            photog_chromadapt_plan_create(PhotogWorkingSpace::Srgb,
+                                          PhotogChromadaptMethod::Bradford,
+                                          PhotogIlluminant::D50,
+                                          PhotogAccuracy::Exact);
+
+    std::cout << std::setw(8) << "size" << std::setw(16) << "per-call us"
+              << std::setw(14) << "plan us" << std::setw(12) << "saved us"
+              << std::endl;
+
+    for (int size : sizes) {
+        std::vector<float> input_storage, output_storage;
+        photog::random_image(input_storage, size, size, channels);
+        output_storage.resize(input_storage.size());
+        PhotogImage input = photog_make_image(input_storage.data(), Float32,
+                                              size, size,
+                                              PhotogLayout::Planar);
+        PhotogImage output = photog_make_image(output_storage.data(), Float32,
+                                               size, size,
+                                               PhotogLayout::Planar);
+
+        double per_call_seconds = Halide::Tools::benchmark(10, 1000, [&]() {
+            photog_chromadapt_image(&input, PhotogWorkingSpace::Srgb,
+                                    PhotogChromadaptMethod::Bradford,
+                                    PhotogIlluminant::D50,
+                                    PhotogAccuracy::Exact, &output);
+        });
+        double plan_seconds = Halide::Tools::benchmark(10, 1000, [&]() {
+            photog_chromadapt_plan_execute(plan, &input, &output);
+        });
+
+        std::cout << std::setw(8)
+                  << std::to_string(size) + "x" + std::to_string(size)
+                  << std::setw(16) << std::fixed << std::setprecision(2)
+                  << per_call_seconds * 1e6
+                  << std::setw(14) << plan_seconds * 1e6
+                  << std::setw(12) << (per_call_seconds - plan_seconds) * 1e6
+                  << std::endl;
+    }
+
+    photog_chromadapt_plan_destroy(plan);
+
+    return 0;
+}
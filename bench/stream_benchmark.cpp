@@ -0,0 +1,94 @@
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+
+namespace {
+    /** Images streamed to and from photog_chromadapt_stream.*/
+    struct StreamedImages {
+        Halide::Runtime::Buffer<float> input;
+        Halide::Runtime::Buffer<float> output;
+    };
+
+    int read_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *images = static_cast<StreamedImages *>(user_context);
+        Halide::Runtime::Buffer<float> buffer =
+                photog::get_buffer<float>(*strip);
+        buffer.translate(1, y);
+        buffer.copy_from(images->input);
+
+        return 0;
+    }
+
+    int write_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *images = static_cast<StreamedImages *>(user_context);
+        Halide::Runtime::Buffer<float> buffer =
+                photog::get_buffer<float>(*strip);
+        buffer.translate(1, y);
+        images->output.copy_from(buffer);
+
+        return 0;
+    }
+}
+
+/** Compares photog_chromadapt on an image held in memory against streaming
+ * the same image through photog_chromadapt_stream in strips of various
+ * heights. Strips are copied from and to memory, so the difference is the
+ * cost of streaming itself: the extra read of each strip, copies and smaller
+ * pipelines.*/
+int main() {
+    const int width{6000}, height{4000}, channels{3};
+    const int strip_heights[]{64, 256, 1024};
+
+    std::vector<float> input_storage, output_storage;
+    StreamedImages images{
+            photog::random_image(input_storage, width, height, channels),
+            photog::random_image(output_storage, width, height, channels)};
+
+    double in_memory_seconds = Halide::Tools::benchmark(10, 3, [&]() {
+        photog_chromadapt_ex(input_storage.data(), width, height,
+                             PhotogLayout::Planar, PhotogWorkingSpace::Srgb,
+                             PhotogChromadaptMethod::Bradford,
+                             PhotogIlluminant::D65, PhotogAccuracy::Exact,
+                             output_storage.data());
+    });
+
+    std::cout << width << "x" << height << " photog_chromadapt" << std::endl;
+    std::cout << std::setw(12) << "strip rows" << std::setw(12) << "ms"
+              << std::setw(12) << "MP/s" << std::setw(14) << "strip MB"
+              << std::endl;
+    std::cout << std::setw(12) << "in-memory" << std::setw(12) << std::fixed
+              << std::setprecision(2) << in_memory_seconds * 1e3
+              << std::setw(12) << std::setprecision(1)
+              << photog::megapixels_per_second(width, height,
+                                               in_memory_seconds)
+              << std::setw(14) << "-" << std::endl;
+
+    for (int strip_height : strip_heights) {
+        double seconds = Halide::Tools::benchmark(10, 3, [&]() {
+            photog_chromadapt_stream(read_strip, write_strip, &images, width,
+                                     height, Float32, PhotogLayout::Planar,
+                                     strip_height, PhotogWorkingSpace::Srgb,
+                                     PhotogChromadaptMethod::Bradford,
+                                     PhotogIlluminant::D65,
+                                     PhotogAccuracy::Exact);
+        });
+        // Input and output strips
+        double strip_megabytes = 2.0 * width * strip_height * channels *
+                                 sizeof(float) / 1e6;
+
+        std::cout << std::setw(12) << strip_height << std::setw(12)
+                  << std::setprecision(2) << seconds * 1e3 << std::setw(12)
+                  << std::setprecision(1)
+                  << photog::megapixels_per_second(width, height, seconds)
+                  << std::setw(14) << strip_megabytes << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Halide.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+#include "color_utils.h"
+// Available after a CMake build
+#include "photog_apply_lut.h"
+#include "photog_apply_lut_interleaved.h"
+#include "photog_average.h"
+#include "photog_average_interleaved.h"
+#include "photog_average_sampled.h"
+#include "photog_average_sampled_interleaved.h"
+#include "photog_chromadapt_folded_impl.h"
+#include "photog_chromadapt_folded_impl_interleaved.h"
+#include "photog_chromadapt_fused_impl.h"
+#include "photog_chromadapt_fused_impl_interleaved.h"
+#include "photog_chromadapt_impl.h"
+#include "photog_histogram.h"
+#include "photog_histogram_interleaved.h"
+#include "photog_illuminant_statistics.h"
+#include "photog_illuminant_statistics_interleaved.h"
+#include "photog_linear_to_rgb.h"
+#include "photog_linear_to_rgb_interleaved.h"
+#include "photog_linear_to_srgb.h"
+#include "photog_linear_to_srgb_interleaved.h"
+#include "photog_rgb_to_linear.h"
+#include "photog_rgb_to_linear_interleaved.h"
+#include "photog_rgb_to_xyz.h"
+#include "photog_rgb_to_xyz_interleaved.h"
+#include "photog_srgb_to_linear.h"
+#include "photog_srgb_to_linear_interleaved.h"
+#include "photog_srgb_to_xyz.h"
+#include "photog_srgb_to_xyz_interleaved.h"
+#include "photog_xyz_to_rgb.h"
+#include "photog_xyz_to_rgb_interleaved.h"
+#include "photog_xyz_to_srgb.h"
+#include "photog_xyz_to_srgb_interleaved.h"
+
+namespace {
+    using Image = Halide::Runtime::Buffer<float>;
+
+    /** A function to benchmark. Reads an image and, unless it reduces the
+     * image, writes one of equal size.*/
+    struct Case {
+        std::string name;
+        PhotogLayout layout;
+        bool writes_image;
+        std::function<void(Image &, Image &)> run;
+    };
+
+    struct Stats {
+        double min, mean, p50, p90, p99;
+    };
+
+    Stats get_stats(std::vector<double> seconds) {
+        std::sort(seconds.begin(), seconds.end());
+        auto percentile = [&](double p) {
+            auto i = static_cast<size_t>(p * (seconds.size() - 1) + 0.5);
+            return seconds[i];
+        };
+        double total{0};
+        for (double s : seconds)
+            total += s;
+
+        return {seconds.front(), total / seconds.size(), percentile(0.5),
+                percentile(0.9), percentile(0.99)};
+    }
+
+    /** Evicts the benchmarked images from the CPU's caches by touching a
+     * buffer larger than any last-level cache.*/
+    void flush_caches() {
+        static std::vector<char> scratch(256 * 1024 * 1024);
+        for (size_t i = 0; i < scratch.size(); i += 64)
+            scratch[i] += 1;
+    }
+
+    std::vector<double> time_case(const Case &c, Image &input, Image &output,
+                                  int samples, bool cold) {
+        std::vector<double> seconds;
+        c.run(input, output); // Excludes first-call set-up from every sample
+        for (int i = 0; i < samples; ++i) {
+            if (cold)
+                flush_caches();
+            auto start = std::chrono::steady_clock::now();
+            c.run(input, output);
+            auto end = std::chrono::steady_clock::now();
+            seconds.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        return seconds;
+    }
+
+    std::string layout_name(PhotogLayout layout) {
+        return layout == PhotogLayout::Planar ? "planar" : "interleaved";
+    }
+
+    /** Identity lookup table of size^3 samples for photog_apply_lut.*/
+    Image get_identity_lut(int size) {
+        Image lut(size, size, size, 3);
+        lut.for_each_element([&](int r, int g, int b, int c) {
+            int position[3]{r, g, b};
+            lut(r, g, b, c) = static_cast<float>(position[c]) / (size - 1);
+        });
+
+        return lut;
+    }
+
+    std::vector<Case> get_cases() {
+        const PhotogWorkingSpace working_space{PhotogWorkingSpace::Srgb};
+        const PhotogChromadaptMethod method{PhotogChromadaptMethod::Bradford};
+        const int slots{PHOTOG_HISTOGRAM_BINS + 2};
+        float gamma = photog::get_gamma(working_space);
+        Image rgb_to_xyz_xfmr = photog::get_rgb_to_xyz_xfmr(working_space);
+        Image xyz_to_rgb_xfmr = photog::get_xyz_to_rgb_xfmr(working_space);
+        Image xyz_to_lms_xfmr = photog::get_xyz_to_lms_xfmr(method);
+        Image lms_to_xyz_xfmr = photog::get_lms_to_xyz_xfmr(method);
+        Image source = photog::copy_to_buffer(
+                photog::get_tristimulus(PhotogIlluminant::A));
+        Image dest = photog::copy_to_buffer(
+                photog::get_tristimulus(PhotogIlluminant::D65));
+        Image transform = photog::create_transform(method, source, dest);
+        Image rgb_transform =
+                photog::create_rgb_transform(working_space, method, source,
+                                             dest);
+        Image lut = get_identity_lut(33);
+        auto average = std::make_shared<Image>(3);
+        auto statistics = std::make_shared<Image>(3, 3);
+        auto counts = std::make_shared<Halide::Runtime::Buffer<uint32_t>>(
+                slots, 3);
+        auto minimums = std::make_shared<Image>(slots, 3);
+        auto maximums = std::make_shared<Image>(slots, 3);
+
+        // Libraries only compiled for planar images.
+        std::vector<Case> cases{
+                {"photog_chromadapt_impl", Planar, true,
+                 [=](Image &in, Image &out) mutable {
+                     photog_chromadapt_impl(in, gamma, rgb_to_xyz_xfmr,
+                                            xyz_to_rgb_xfmr, transform, out);
+                 }}};
+
+        // Libraries compiled for both layouts, picking each layout's
+        // variant.
+        for (PhotogLayout layout : {Planar, Interleaved}) {
+            bool planar = layout == Planar;
+            auto srgb_to_linear = planar ? photog_srgb_to_linear :
+                                  photog_srgb_to_linear_interleaved;
+            auto rgb_to_linear = planar ? photog_rgb_to_linear :
+                                 photog_rgb_to_linear_interleaved;
+            auto srgb_to_xyz = planar ? photog_srgb_to_xyz :
+                               photog_srgb_to_xyz_interleaved;
+            auto rgb_to_xyz = planar ? photog_rgb_to_xyz :
+                              photog_rgb_to_xyz_interleaved;
+            auto linear_to_srgb = planar ? photog_linear_to_srgb :
+                                  photog_linear_to_srgb_interleaved;
+            auto linear_to_rgb = planar ? photog_linear_to_rgb :
+                                 photog_linear_to_rgb_interleaved;
+            auto xyz_to_srgb = planar ? photog_xyz_to_srgb :
+                               photog_xyz_to_srgb_interleaved;
+            auto xyz_to_rgb = planar ? photog_xyz_to_rgb :
+                              photog_xyz_to_rgb_interleaved;
+            auto average_image = planar ? photog_average :
+                                 photog_average_interleaved;
+            auto average_sampled = planar ? photog_average_sampled :
+                                   photog_average_sampled_interleaved;
+            auto illuminant_statistics =
+                    planar ? photog_illuminant_statistics :
+                    photog_illuminant_statistics_interleaved;
+            auto histogram = planar ? photog_histogram :
+                             photog_histogram_interleaved;
+            auto apply_lut = planar ? photog_apply_lut :
+                             photog_apply_lut_interleaved;
+            auto chromadapt_folded = planar ? photog_chromadapt_folded_impl :
+                                     photog_chromadapt_folded_impl_interleaved;
+            auto chromadapt_fused = planar ? photog_chromadapt_fused_impl :
+                                    photog_chromadapt_fused_impl_interleaved;
+
+            std::vector<Case> layout_cases{
+                    {"photog_srgb_to_linear", layout, true,
+                     [=](Image &in, Image &out) { srgb_to_linear(in, out); }},
+                    {"photog_rgb_to_linear", layout, true,
+                     [=](Image &in, Image &out) {
+                         rgb_to_linear(in, gamma, out);
+                     }},
+                    {"photog_srgb_to_xyz", layout, true,
+                     [=](Image &in, Image &out) { srgb_to_xyz(in, out); }},
+                    {"photog_rgb_to_xyz", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         rgb_to_xyz(in, gamma, rgb_to_xyz_xfmr, out);
+                     }},
+                    {"photog_linear_to_srgb", layout, true,
+                     [=](Image &in, Image &out) { linear_to_srgb(in, out); }},
+                    {"photog_linear_to_rgb", layout, true,
+                     [=](Image &in, Image &out) {
+                         linear_to_rgb(in, gamma, out);
+                     }},
+                    {"photog_xyz_to_srgb", layout, true,
+                     [=](Image &in, Image &out) { xyz_to_srgb(in, out); }},
+                    {"photog_xyz_to_rgb", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         xyz_to_rgb(in, gamma, xyz_to_rgb_xfmr, out);
+                     }},
+                    {"photog_average", layout, false,
+                     [=](Image &in, Image &) { average_image(in, *average); }},
+                    // Reads 1/64 of the pixels.
+                    {"photog_average_sampled", layout, false,
+                     [=](Image &in, Image &) {
+                         average_sampled(in, 8, *average);
+                     }},
+                    {"photog_illuminant_statistics", layout, false,
+                     [=](Image &in, Image &) {
+                         illuminant_statistics(in, 6.0f, *statistics);
+                     }},
+                    {"photog_histogram", layout, false,
+                     [=](Image &in, Image &) {
+                         histogram(in, *counts, *minimums, *maximums);
+                     }},
+                    {"photog_apply_lut", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         apply_lut(in, lut, out);
+                     }},
+                    {"photog_chromadapt_folded_impl", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         chromadapt_folded(in, gamma, rgb_transform, out);
+                     }},
+                    {"photog_chromadapt_fused_impl", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         chromadapt_fused(in, 1, gamma, rgb_to_xyz_xfmr,
+                                          xyz_to_rgb_xfmr, xyz_to_lms_xfmr,
+                                          lms_to_xyz_xfmr, dest, out);
+                     }}};
+            cases.insert(cases.end(), layout_cases.begin(),
+                         layout_cases.end());
+        }
+
+        for (PhotogLayout layout : {Planar, Interleaved}) {
+            cases.push_back(
+                    {"photog_chromadapt", layout, true,
+                     [=](Image &in, Image &out) {
+                         photog_chromadapt_ex(in.data(), in.width(),
+                                              in.height(), layout,
+                                              working_space, method,
+                                              PhotogIlluminant::D65,
+                                              PhotogAccuracy::Exact,
+                                              out.data());
+                     }});
+            cases.push_back(
+                    {"photog_chromadapt_diy", layout, true,
+                     [=](Image &in, Image &out) mutable {
+                         photog_chromadapt_diy_ex(in.data(), in.width(),
+                                                  in.height(), layout,
+                                                  source.data(), working_space,
+                                                  method, dest.data(),
+                                                  PhotogAccuracy::Exact,
+                                                  out.data());
+                     }});
+            // Estimates from 1/64 of the pixels before adapting every one.
+            cases.push_back(
+                    {"photog_chromadapt_sampled_image", layout, true,
+                     [=](Image &in, Image &out) {
+                         PhotogImage input =
+                                 photog_make_image(in.data(), Float32,
+                                                   in.width(), in.height(),
+                                                   layout);
+                         PhotogImage output =
+                                 photog_make_image(out.data(), Float32,
+                                                   out.width(), out.height(),
+                                                   layout);
+                         photog_chromadapt_sampled_image(
+                                 &input, 8, working_space, method,
+                                 PhotogIlluminant::D65, PhotogAccuracy::Exact,
+                                 &output);
+                     }});
+            // Converts the output image in place, so no second image is
+            // read. Repeated runs push values towards 1, never denormals.
+            cases.push_back(
+                    {"photog_linear_to_srgb_in_place", layout, true,
+                     [=](Image &, Image &out) {
+                         PhotogImage image =
+                                 photog_make_image(out.data(), Float32,
+                                                   out.width(), out.height(),
+                                                   layout);
+                         photog_linear_to_srgb_in_place(&image,
+                                                        PhotogAccuracy::Exact);
+                     }});
+        }
+
+        return cases;
+    }
+}
+
+/** Times every generated color library dispatched to by photog's public
+ * functions, the reference photog_chromadapt_impl and photog's public
+ * chromatic adaptation functions over image sizes from 64x64 to 8K, in each
+ * layout they are compiled for, with warm and cold caches.
+ *
+ * Results are written as JSON to the path given as the first argument, or
+ * to stdout, so they can be diffed between releases. Float images with exact
+ * transfer functions are measured.*/
+int main(int argc, char **argv) {
+    const int sizes[][2]{{64,   64},
+                         {256,  256},
+                         {512,  512},
+                         {1920, 1080},
+                         {3840, 2160},
+                         {7680, 4320}};
+    const int channels{3};
+    std::vector<Case> cases = get_cases();
+
+    std::ofstream file;
+    if (argc > 1)
+        file.open(argv[1]);
+    std::ostream &json = argc > 1 ? file : std::cout;
+
+    json << "{\n  \"target\": \"" << Halide::get_host_target().to_string()
+         << "\",\n  \"results\": [";
+    bool first{true};
+    for (const auto &size : sizes) {
+        const int width{size[0]}, height{size[1]};
+        // Fewer samples for larger images keeps each size's run time similar.
+        const int samples =
+                std::clamp(static_cast<int>(2e7 / (width * height)), 10, 200);
+
+        for (PhotogLayout layout : {Planar, Interleaved}) {
+            std::vector<float> input_storage, output_storage;
+            Image input = photog::random_image(input_storage, width, height,
+                                               channels, layout);
+            Image output = photog::random_image(output_storage, width, height,
+                                                channels, layout);
+            double image_bytes = static_cast<double>(width) * height *
+                                 channels * sizeof(float);
+
+            for (const Case &c : cases) {
+                if (c.layout != layout)
+                    continue;
+
+                for (bool cold : {false, true}) {
+                    Stats stats = get_stats(time_case(c, input, output,
+                                                      samples, cold));
+                    double bytes = image_bytes * (c.writes_image ? 2 : 1);
+
+                    json << (first ? "" : ",") << "\n    {\"function\": \""
+                         << c.name << "\", \"layout\": \""
+                         << layout_name(layout) << "\", \"width\": " << width
+                         << ", \"height\": " << height << ", \"cache\": \""
+                         << (cold ? "cold" : "warm") << "\", \"samples\": "
+                         << samples << ", \"seconds\": {\"min\": "
+                         << stats.min << ", \"mean\": " << stats.mean
+                         << ", \"p50\": " << stats.p50 << ", \"p90\": "
+                         << stats.p90 << ", \"p99\": " << stats.p99
+                         << "}, \"mp_per_second\": "
+                         << photog::megapixels_per_second(width, height,
+                                                          stats.p50)
+                         << ", \"gb_per_second\": "
+                         << bytes / 1e9 / stats.p50 << "}";
+                    first = false;
+                }
+            }
+
+            std::cerr << "Finished " << width << "x" << height << " "
+                      << layout_name(layout) << std::endl;
+        }
+    }
+    json << "\n  ]\n}" << std::endl;
+
+    return 0;
+}
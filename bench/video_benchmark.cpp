@@ -0,0 +1,116 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Halide.h"
+
+#include "photog/color.h"
+#include "benchmark_utils.h"
+
+namespace {
+    /** Scales the channels of a frame to simulate an illuminant that
+     * changes over the sequence. Returns the frame's descriptor.*/
+    PhotogImage make_frame(const std::vector<float> &source,
+                           std::vector<float> &frame, int width, int height,
+                           float red_gain) {
+        const size_t plane{static_cast<size_t>(width) * height};
+        frame = source;
+        for (size_t i = 0; i < plane; ++i)
+            frame[i] *= red_gain;
+
+        return photog_make_image(frame.data(), Float32, width, height,
+                                 PhotogLayout::Planar);
+    }
+
+    /** Seconds taken to adapt each frame of a sequence through a video
+     * session with the given smoothing.*/
+    double time_session(const std::vector<PhotogImage> &frames,
+                        PhotogImage &output, float smoothing,
+                        float drift_threshold, PhotogVideoReport &report) {
+        PhotogVideoSession *session =
+                photog_video_session_create(PhotogWorkingSpace::Srgb,
+                                            PhotogChromadaptMethod::Bradford,
+                                            PhotogIlluminant::D65,
+                                            PhotogAccuracy::Exact, smoothing,
+                                            drift_threshold);
+        auto start = std::chrono::steady_clock::now();
+        for (const PhotogImage &frame : frames)
+            photog_video_session_process(session, &frame, &output);
+        auto end = std::chrono::steady_clock::now();
+        photog_video_session_report(session, &report);
+        photog_video_session_destroy(session);
+
+        return std::chrono::duration<double>(end - start).count();
+    }
+}
+
+/** Measures frames per second of chromatically adapting a synthetic 1080p
+ * sequence frame by frame with photog_chromadapt_image against a video
+ * session. The sequence holds a still scene whose illuminant then shifts
+ * over a few frames.*/
+int main() {
+    const int width{1920}, height{1080}, channels{3};
+    const int still_frames{120}, shifting_frames{8}, settled_frames{120};
+
+    std::vector<float> source, output_storage;
+    photog::random_image(source, width, height, channels);
+    output_storage.resize(source.size());
+    PhotogImage output = photog_make_image(output_storage.data(), Float32,
+                                           width, height,
+                                           PhotogLayout::Planar);
+
+    // Only distinct frames are stored. The sequence repeats them in order.
+    std::vector<std::vector<float>> storage(shifting_frames + 2);
+    std::vector<PhotogImage> distinct;
+    for (int i = 0; i < shifting_frames + 2; ++i)
+        distinct.push_back(make_frame(source, storage[i], width, height,
+                                      1.0f - 0.4f * i / (shifting_frames + 1)));
+    std::vector<PhotogImage> frames;
+    for (int i = 0; i < still_frames; ++i)
+        frames.push_back(distinct.front());
+    for (int i = 1; i <= shifting_frames; ++i)
+        frames.push_back(distinct[i]);
+    for (int i = 0; i < settled_frames; ++i)
+        frames.push_back(distinct.back());
+
+    // Excludes first-call set-up from both measurements.
+    photog_chromadapt_image(&frames.front(), PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D65, PhotogAccuracy::Exact,
+                            &output);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const PhotogImage &frame : frames)
+        photog_chromadapt_image(&frame, PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                PhotogIlluminant::D65, PhotogAccuracy::Exact,
+                                &output);
+    auto end = std::chrono::steady_clock::now();
+    double per_frame_seconds =
+            std::chrono::duration<double>(end - start).count();
+
+    std::cout << frames.size() << " frames of " << width << "x" << height
+              << std::endl;
+    std::cout << std::setw(28) << "method" << std::setw(10) << "fps"
+              << std::setw(12) << "estimates" << std::setw(12) << "updates"
+              << std::endl;
+    std::cout << std::setw(28) << "photog_chromadapt_image"
+              << std::setw(10) << std::fixed << std::setprecision(1)
+              << frames.size() / per_frame_seconds
+              << std::setw(12) << frames.size()
+              << std::setw(12) << frames.size() << std::endl;
+
+    for (float smoothing : {1.0f, 0.25f}) {
+        PhotogVideoReport report{};
+        double seconds = time_session(frames, output, smoothing, 1.0f, report);
+        std::cout << std::setw(20) << "session, smoothing "
+                  << std::setw(8) << std::setprecision(2) << smoothing
+                  << std::setw(10) << std::setprecision(1)
+                  << frames.size() / seconds
+                  << std::setw(12) << report.estimated_frames
+                  << std::setw(12) << report.transform_updates << std::endl;
+    }
+
+    return 0;
+}
@@ -1,56 +1,1304 @@
 #include "photog/color.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
 
 #include "Halide.h"
+#include "HalideRuntime.h"
 
+#include "color_libraries.h"
 #include "color_utils.h"
-#include "photog_average.h"
-#include "photog_chromadapt_impl.h"
+#include "jit.h"
+#include "raw_format.h"
 #include "utils.h"
 
+namespace photog {
+    template<typename T>
+    void chromadapt_diy(const PhotogImage &input, float *source_tristimulus,
+                        PhotogWorkingSpace working_space,
+                        PhotogChromadaptMethod chromadapt_method,
+                        float *dest_tristimulus, PhotogAccuracy accuracy,
+                        const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input, output);
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<float> source_est(source_tristimulus, 3);
+        Halide::Runtime::Buffer<float> dest(dest_tristimulus, 3);
+        Halide::Runtime::Buffer<T> out = photog::get_buffer<T>(output);
+
+        Halide::Runtime::Buffer<float> rgb_transform =
+                photog::create_rgb_transform(working_space, chromadapt_method,
+                                             source_est, dest);
+
+        SizeBucket size = photog::get_size_bucket(input.extent[0],
+                                                  input.extent[1]);
+
+        photog::ColorLibraries<T>::chromadapt_folded_impl(input.alpha, layout,
+                                                          size, accuracy)(
+                in, photog::get_gamma(working_space), rgb_transform, out);
+    }
+
+    /** Minkowski norm of shades-of-gray and gray-edge estimates.*/
+    const float estimator_norm{6.0f};
+
+    /** Estimates the XYZ tristimulus values of an image's illuminant.
+     *
+     * Gray-world estimates are read from the cheaper average library. Other
+     * estimates are picked from statistics gathered for every estimator in
+     * one read of the image.*/
+    template<typename T>
+    Halide::Runtime::Buffer<float>
+    estimate_illuminant(const PhotogImage &input,
+                        PhotogIlluminantEstimator estimator,
+                        PhotogWorkingSpace working_space) {
+        PhotogLayout layout = photog::get_layout(input);
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<float> source_est(3);
+
+        if (estimator == PhotogIlluminantEstimator::GrayWorld) {
+            photog::ColorLibraries<T>::average(input.alpha, layout)(
+                    in, source_est);
+        } else {
+            Halide::Runtime::Buffer<float> statistics(3, 3);
+            photog::ColorLibraries<T>::illuminant_statistics(input.alpha,
+                                                             layout)(
+                    in, estimator_norm, statistics);
+            for (int c = 0; c < 3; ++c)
+                source_est(c) = statistics(
+                        c, estimator - PhotogIlluminantEstimator::WhitePatch);
+        }
+
+        return photog::rgb_to_xyz(source_est,
+                                  photog::get_gamma(working_space),
+                                  photog::get_rgb_to_xyz_xfmr(working_space));
+    }
+
+    /** Estimates the XYZ tristimulus values of an image's illuminant with
+     * the gray-world method from every sample_factor-th pixel in each
+     * dimension.*/
+    template<typename T>
+    Halide::Runtime::Buffer<float>
+    estimate_illuminant_sampled(const PhotogImage &input, int sample_factor,
+                                PhotogWorkingSpace working_space) {
+        PhotogLayout layout = photog::get_layout(input);
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<float> source_est(3);
+
+        photog::ColorLibraries<T>::average_sampled(input.alpha, layout)(
+                in, sample_factor, source_est);
+
+        return photog::rgb_to_xyz(source_est,
+                                  photog::get_gamma(working_space),
+                                  photog::get_rgb_to_xyz_xfmr(working_space));
+    }
+
+    /** Angle in degrees between two tristimulus estimates. Angles ignore
+     * brightness, so they compare the chromaticity of estimates.*/
+    float angular_error(const Halide::Runtime::Buffer<float> &a,
+                        const Halide::Runtime::Buffer<float> &b) {
+        double dot{0}, a_norm{0}, b_norm{0};
+        for (int c = 0; c < 3; ++c) {
+            dot += static_cast<double>(a(c)) * b(c);
+            a_norm += static_cast<double>(a(c)) * a(c);
+            b_norm += static_cast<double>(b(c)) * b(c);
+        }
+        double cosine = std::clamp(dot / std::sqrt(a_norm * b_norm), -1.0,
+                                   1.0);
+        const double degrees_per_radian{180.0 / 3.14159265358979323846};
+
+        return static_cast<float>(std::acos(cosine) * degrees_per_radian);
+    }
+
+    /** Reports the accuracy of a subsampled estimate against an estimate
+     * from every pixel.*/
+    template<typename T>
+    PhotogSamplingReport
+    get_sampling_report(const PhotogImage &input, int sample_factor,
+                        PhotogWorkingSpace working_space,
+                        const Halide::Runtime::Buffer<float> &estimate) {
+        Halide::Runtime::Buffer<float> full =
+                photog::estimate_illuminant<T>(
+                        input, PhotogIlluminantEstimator::GrayWorld,
+                        working_space);
+        double sampled_pixels =
+                static_cast<double>((input.extent[0] - 1) / sample_factor + 1) *
+                ((input.extent[1] - 1) / sample_factor + 1);
+        double pixels = static_cast<double>(input.extent[0]) * input.extent[1];
+
+        return {static_cast<float>(sampled_pixels / pixels),
+                photog::angular_error(estimate, full)};
+    }
+
+    template<typename T>
+    void chromadapt(const PhotogImage &input,
+                    PhotogIlluminantEstimator estimator,
+                    PhotogWorkingSpace working_space,
+                    PhotogChromadaptMethod chromadapt_method,
+                    PhotogIlluminant dest_illuminant,
+                    PhotogAccuracy accuracy, const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input, output);
+
+        // JIT pipelines are only compiled for gray-world estimates of images
+        // without alpha.
+        if (photog::get_backend() == PhotogBackend::Jit &&
+            estimator == PhotogIlluminantEstimator::GrayWorld &&
+            input.alpha == PhotogAlpha::Opaque) {
+            ChromadaptConstants constants =
+                    photog::get_chromadapt_constants(working_space,
+                                                     chromadapt_method,
+                                                     dest_illuminant);
+            photog::jit_chromadapt(photog::get_buffer<T>(input), layout,
+                                   constants, accuracy,
+                                   photog::get_buffer<T>(output));
+            return;
+        }
+
+        Halide::Runtime::Buffer<float> source_est =
+                photog::estimate_illuminant<T>(input, estimator,
+                                               working_space);
+
+        std::array<float, 3> dest_tristimulus =
+                photog::get_tristimulus(dest_illuminant);
+
+        photog::chromadapt_diy<T>(input, source_est.data(), working_space,
+                                  chromadapt_method, dest_tristimulus.data(),
+                                  accuracy, output);
+    }
+
+    /** Returns the error code of the generated library, zero on success.*/
+    template<typename T>
+    int chromadapt_fused(const PhotogImage &input, int sample_factor,
+                         ChromadaptConstants &constants,
+                         PhotogAccuracy accuracy, const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input, output);
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<T> out = photog::get_buffer<T>(output);
+
+        return photog::ColorLibraries<T>::chromadapt_fused_impl(
+                input.alpha, layout, accuracy)(
+                in, sample_factor, constants.gamma, constants.rgb_to_xyz_xfmr,
+                constants.xyz_to_rgb_xfmr, constants.xyz_to_lms_xfmr,
+                constants.lms_to_xyz_xfmr, constants.dest_tristimulus, out);
+    }
+
+    /** Calls function with a value of the C++ type matching an element
+     * type. The function recovers the type with decltype.*/
+    template<typename Function>
+    void dispatch(PhotogElementType type, Function function) {
+        if (type == PhotogElementType::Float32)
+            function(float{});
+        else if (type == PhotogElementType::Uint8)
+            function(uint8_t{});
+        else if (type == PhotogElementType::Uint16)
+            function(uint16_t{});
+        else if (type == PhotogElementType::Float16)
+            function(Halide::float16_t{});
+        else {
+            std::cerr << "Unsupported element type " << static_cast<int>(type)
+                      << " in photog::dispatch()." << std::endl;
+            abort();
+        }
+    }
+
+    /** Converts the color space of an image with a generated conversion
+     * library, passing args between the input and output images.
+     *
+     * Conversion libraries are scheduled so that input and output may
+     * describe the same image.*/
+    template<typename T, typename Library, typename... Args>
+    void convert(Library library, const PhotogImage &input,
+                 const PhotogImage &output, Args &&... args) {
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<T> out = photog::get_buffer<T>(output);
+
+        library(in, args..., out);
+    }
+
+    template<typename T>
+    void image_statistics(const PhotogImage &image,
+                          PhotogImageStatistics &statistics) {
+        const int bins{PHOTOG_HISTOGRAM_BINS}, slots{bins + 2};
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(image);
+        Halide::Runtime::Buffer<uint32_t> counts(slots, 3);
+        Halide::Runtime::Buffer<float> minimums(slots, 3);
+        Halide::Runtime::Buffer<float> maximums(slots, 3);
+
+        photog::ColorLibraries<T>::histogram(image.alpha,
+                                             photog::get_layout(image))(
+                in, counts, minimums, maximums);
+
+        for (int c = 0; c < 3; ++c) {
+            // Slots of values outside of 0 to 1 are folded into the end bins.
+            for (int b = 0; b < bins; ++b)
+                statistics.histogram[c][b] = counts(b + 1, c);
+            statistics.histogram[c][0] += counts(0, c);
+            statistics.histogram[c][bins - 1] += counts(slots - 1, c);
+            statistics.clipped_low[c] = counts(0, c);
+            statistics.clipped_high[c] = counts(slots - 1, c);
+
+            // Extrema are those of the outermost slots holding values.
+            statistics.min[c] = 0.0f;
+            statistics.max[c] = 0.0f;
+            for (int b = 0; b < slots; ++b) {
+                if (counts(b, c) > 0) {
+                    statistics.min[c] = minimums(b, c);
+                    break;
+                }
+            }
+            for (int b = slots - 1; b >= 0; --b) {
+                if (counts(b, c) > 0) {
+                    statistics.max[c] = maximums(b, c);
+                    break;
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    void apply_lut(int size, const float *samples, const PhotogImage &input,
+                   const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input, output);
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<const float> lut(samples, size, size, size, 3);
+        Halide::Runtime::Buffer<T> out = photog::get_buffer<T>(output);
+
+        photog::ColorLibraries<T>::apply_lut(input.alpha, layout)(in, lut,
+                                                                   out);
+    }
+
+    /** Images of a batch and the constants they share. Passed to each
+     * task of photog_chromadapt_batch as its closure.*/
+    struct ChromadaptBatch {
+        const PhotogImage *inputs;
+        const PhotogImage *outputs;
+        ChromadaptConstants *constants;
+        PhotogAccuracy accuracy;
+    };
+
+    int chromadapt_batch_task(void *user_context, int i, uint8_t *closure) {
+        auto *batch = reinterpret_cast<ChromadaptBatch *>(closure);
+        int result{0};
+        photog::dispatch(batch->inputs[i].type, [&](auto element) {
+            // Sampling every pixel matches photog_chromadapt's estimate.
+            result = photog::chromadapt_fused<decltype(element)>(
+                    batch->inputs[i], 1, *batch->constants, batch->accuracy,
+                    batch->outputs[i]);
+        });
+
+        return result;
+    }
+
+    template<typename T>
+    int chromadapt_stream(PhotogReadStrip read, PhotogWriteStrip write,
+                          void *user_context, int width, int height,
+                          PhotogElementType type, PhotogLayout layout,
+                          int strip_height, PhotogWorkingSpace working_space,
+                          PhotogChromadaptMethod chromadapt_method,
+                          PhotogIlluminant dest_illuminant,
+                          PhotogAccuracy accuracy) {
+        const int channels = 3;
+        strip_height = std::min(strip_height, height);
+        std::vector<T> input_storage(static_cast<size_t>(width) *
+                                     strip_height * channels);
+        std::vector<T> output_storage(input_storage.size());
+        PhotogImage input = photog_make_image(input_storage.data(), type,
+                                              width, strip_height, layout);
+        PhotogImage output = photog_make_image(output_storage.data(), type,
+                                               width, strip_height, layout);
+
+        // Strip averages are weighted by their rows so that the estimate
+        // matches the average of the whole image.
+        std::array<double, 3> sum{};
+        Halide::Runtime::Buffer<float> strip_average(channels);
+        for (int y = 0; y < height; y += strip_height) {
+            PhotogImage strip = photog_crop_image(
+                    input, 0, 0, width, std::min(strip_height, height - y));
+            int result = read(user_context, y, &strip);
+            if (result != 0)
+                return result;
+
+            Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(strip);
+            photog::ColorLibraries<T>::average(strip.alpha, layout)(
+                    in, strip_average);
+            for (int c = 0; c < channels; ++c)
+                sum[c] += static_cast<double>(strip_average(c)) *
+                          strip.extent[1];
+        }
+
+        Halide::Runtime::Buffer<float> source_est(channels);
+        for (int c = 0; c < channels; ++c)
+            source_est(c) = static_cast<float>(sum[c] / height);
+        float gamma = photog::get_gamma(working_space);
+        source_est = photog::rgb_to_xyz(
+                source_est, gamma, photog::get_rgb_to_xyz_xfmr(working_space));
+        Halide::Runtime::Buffer<float> dest = photog::copy_to_buffer(
+                photog::get_tristimulus(dest_illuminant));
+        Halide::Runtime::Buffer<float> rgb_transform =
+                photog::create_rgb_transform(working_space, chromadapt_method,
+                                             source_est, dest);
+
+        SizeBucket size = photog::get_size_bucket(width, strip_height);
+
+        for (int y = 0; y < height; y += strip_height) {
+            int rows = std::min(strip_height, height - y);
+            PhotogImage input_strip = photog_crop_image(input, 0, 0, width,
+                                                        rows);
+            PhotogImage output_strip = photog_crop_image(output, 0, 0, width,
+                                                         rows);
+            int result = read(user_context, y, &input_strip);
+            if (result != 0)
+                return result;
+
+            Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input_strip);
+            Halide::Runtime::Buffer<T> out =
+                    photog::get_buffer<T>(output_strip);
+            photog::ColorLibraries<T>::chromadapt_folded_impl(
+                    input_strip.alpha, layout, size, accuracy)(
+                    in, gamma, rgb_transform, out);
+
+            result = write(user_context, y, &output_strip);
+            if (result != 0)
+                return result;
+        }
+
+        return 0;
+    }
+
+    /** Sample factor that video estimates coarsen to while a scene is
+     * stable.*/
+    const int max_video_sample_factor{16};
+
+    /** Frames between estimates once video estimates reach
+     * max_video_sample_factor.*/
+    const int stable_video_estimate_interval{4};
+
+    /** State carried between the frames of a video session.*/
+    struct VideoState {
+        PhotogWorkingSpace working_space;
+        PhotogChromadaptMethod chromadapt_method;
+        PhotogAccuracy accuracy;
+        float smoothing;
+        float drift_threshold;
+        Halide::Runtime::Buffer<float> dest;
+        /** Moving average of the estimated source illuminant.*/
+        Halide::Runtime::Buffer<float> smoothed;
+        /** Source illuminant that rgb_transform adapts from.*/
+        Halide::Runtime::Buffer<float> transform_source;
+        Halide::Runtime::Buffer<float> rgb_transform;
+        int frames_until_estimate;
+        PhotogVideoReport report;
+    };
+
+    /** Updates a session's smoothed estimate from a frame, coarsening or
+     * skipping later estimates while the scene is stable, and rebuilds its
+     * transform once the smoothed estimate drifts.*/
+    template<typename T>
+    void track_illuminant(VideoState &state, const PhotogImage &input) {
+        PhotogVideoReport &report = state.report;
+        if (state.frames_until_estimate > 0) {
+            --state.frames_until_estimate;
+            return;
+        }
+
+        Halide::Runtime::Buffer<float> estimate =
+                photog::estimate_illuminant_sampled<T>(
+                        input, report.sample_factor, state.working_space);
+        ++report.estimated_frames;
+
+        if (report.frames == 0) {
+            state.smoothed = estimate.copy();
+        } else {
+            // Estimates near the moving average mark the scene as stable.
+            if (photog::angular_error(estimate, state.smoothed) <
+                state.drift_threshold) {
+                report.sample_factor = std::min(report.sample_factor * 2,
+                                                max_video_sample_factor);
+                if (report.sample_factor == max_video_sample_factor)
+                    state.frames_until_estimate =
+                            stable_video_estimate_interval - 1;
+            } else {
+                report.sample_factor = 1;
+            }
+
+            for (int c = 0; c < 3; ++c)
+                state.smoothed(c) += state.smoothing *
+                                     (estimate(c) - state.smoothed(c));
+        }
+        for (int c = 0; c < 3; ++c)
+            report.source_tristimulus[c] = state.smoothed(c);
+
+        if (report.frames == 0 ||
+            photog::angular_error(state.smoothed, state.transform_source) >
+            state.drift_threshold) {
+            state.transform_source = state.smoothed.copy();
+            state.rgb_transform = photog::create_rgb_transform(
+                    state.working_space, state.chromadapt_method,
+                    state.transform_source, state.dest);
+            ++report.transform_updates;
+        }
+    }
+
+    template<typename T>
+    void process_video_frame(VideoState &state, const PhotogImage &input,
+                             const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input, output);
+        photog::track_illuminant<T>(state, input);
+        ++state.report.frames;
+
+        Halide::Runtime::Buffer<T> in = photog::get_buffer<T>(input);
+        Halide::Runtime::Buffer<T> out = photog::get_buffer<T>(output);
+        SizeBucket size = photog::get_size_bucket(input.extent[0],
+                                                  input.extent[1]);
+
+        photog::ColorLibraries<T>::chromadapt_folded_impl(input.alpha, layout,
+                                                          size,
+                                                          state.accuracy)(
+                in, photog::get_gamma(state.working_space),
+                state.rgb_transform, out);
+    }
+
+    /** Raw image files streamed by photog_chromadapt_file. Passed to its
+     * strip callbacks as their user context.
+     *
+     * Pixels start after each file's RawHeader.*/
+    struct RawFiles {
+        std::ifstream input;
+        std::ofstream output;
+        int height;
+        size_t element_size;
+    };
+
+    /** Moves each row of a strip between memory and its position in a raw
+     * image file with transfer(position, data, bytes).
+     *
+     * Planar files hold each channel's plane in turn, so rows of each channel
+     * are moved separately.*/
+    template<typename Transfer>
+    bool transfer_strip(const RawFiles &files, int y, const PhotogImage &strip,
+                        Transfer transfer) {
+        const int channels = 3;
+        bool planar = photog::get_layout(strip) == PhotogLayout::Planar;
+        int planes = planar ? channels : 1;
+        std::streamsize row_elements =
+                planar ? strip.extent[0] : strip.extent[0] * channels;
+
+        for (int p = 0; p < planes; ++p) {
+            for (int row = 0; row < strip.extent[1]; ++row) {
+                std::streamoff file_row =
+                        planar ? static_cast<std::streamoff>(p) * files.height +
+                                 y + row : y + row;
+                ptrdiff_t element =
+                        static_cast<ptrdiff_t>(strip.offset[0]) *
+                        strip.stride[0] +
+                        static_cast<ptrdiff_t>(strip.offset[1] + row) *
+                        strip.stride[1] +
+                        static_cast<ptrdiff_t>(p) * strip.stride[2];
+
+                if (!transfer(static_cast<std::streamoff>(sizeof(RawHeader)) +
+                              file_row * row_elements * files.element_size,
+                              static_cast<char *>(strip.data) +
+                              element * files.element_size,
+                              row_elements * files.element_size))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    int read_raw_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *files = static_cast<RawFiles *>(user_context);
+        bool read = photog::transfer_strip(
+                *files, y, *strip,
+                [&](std::streamoff position, char *data,
+                    std::streamsize bytes) {
+                    files->input.seekg(position);
+                    files->input.read(data, bytes);
+                    return static_cast<bool>(files->input);
+                });
+
+        return read ? 0 : 1;
+    }
+
+    int write_raw_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *files = static_cast<RawFiles *>(user_context);
+        bool written = photog::transfer_strip(
+                *files, y, *strip,
+                [&](std::streamoff position, char *data,
+                    std::streamsize bytes) {
+                    files->output.seekp(position);
+                    files->output.write(data, bytes);
+                    return static_cast<bool>(files->output);
+                });
+
+        return written ? 0 : 1;
+    }
+}
+
+struct PhotogChromadaptPlan {
+    photog::ChromadaptConstants constants;
+    PhotogAccuracy accuracy;
+};
+
+struct PhotogVideoSession {
+    photog::VideoState state;
+};
+
+struct PhotogLut {
+    int size;
+    /** Samples of the transform, held as a planar size^2 x size image whose
+     * pixel (r + size * g, b) holds grid point (r, g, b).*/
+    std::vector<float> samples;
+};
+
+PhotogImage photog_make_image(void *data, PhotogElementType type, int width,
+                              int height, PhotogLayout layout) {
+    return photog_make_image_with_alpha(data, type, width, height, layout,
+                                        PhotogAlpha::Opaque);
+}
+
+PhotogImage photog_make_image_with_alpha(void *data, PhotogElementType type,
+                                         int width, int height,
+                                         PhotogLayout layout,
+                                         PhotogAlpha alpha) {
+    PhotogImage image{data, type, {1, width, width * height}, {0, 0},
+                      {width, height}, alpha};
+    const int channels = photog::get_channels(image);
+
+    if (layout == PhotogLayout::Interleaved) {
+        image.stride[0] = channels;
+        image.stride[1] = width * channels;
+        image.stride[2] = 1;
+    }
+
+    return image;
+}
+
+PhotogImage photog_crop_image(PhotogImage image, int x, int y, int width,
+                              int height) {
+    // Descriptors are wrapped without copies, so regions outside the image
+    // would read and write outside its allocation.
+    if (x < 0 || y < 0 || width < 1 || height < 1 ||
+        x > image.extent[0] - width || y > image.extent[1] - height) {
+        std::cerr << "Unsupported region (" << x << ", " << y << ", "
+                  << width << ", " << height << ") of a " << image.extent[0]
+                  << "x" << image.extent[1]
+                  << " image in photog_crop_image()." << std::endl;
+        abort();
+    }
+
+    image.offset[0] += x;
+    image.offset[1] += y;
+    image.extent[0] = width;
+    image.extent[1] = height;
+
+    return image;
+}
+
 void photog_chromadapt_diy(float *input, int width, int height,
                            float *source_tristimulus,
                            PhotogWorkingSpace working_space,
                            PhotogChromadaptMethod chromadapt_method,
                            float *dest_tristimulus, float *output) {
-    const int channels = 3;
-    Halide::Runtime::Buffer<float> in =
-            photog::get_buffer<float>(input, width, height, channels);
-    Halide::Runtime::Buffer<float> source_est(source_tristimulus, 3);
-    Halide::Runtime::Buffer<float> dest(dest_tristimulus, 3);
-    Halide::Runtime::Buffer<float> out =
-            photog::get_buffer<float>(output, width, height, channels);
+    photog_chromadapt_diy_ex(input, width, height, PhotogLayout::IMAGE_LAYOUT,
+                             source_tristimulus, working_space,
+                             chromadapt_method, dest_tristimulus,
+                             PhotogAccuracy::Exact, output);
+}
 
-    Halide::Runtime::Buffer<float> transform =
-            photog::create_transform(chromadapt_method, source_est, dest);
+void photog_chromadapt_diy_ex(float *input, int width, int height,
+                              PhotogLayout layout,
+                              float *source_tristimulus,
+                              PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              float *dest_tristimulus, PhotogAccuracy accuracy,
+                              float *output) {
+    photog::chromadapt_diy<float>(
+            photog_make_image(input, Float32, width, height, layout),
+            source_tristimulus, working_space, chromadapt_method,
+            dest_tristimulus, accuracy,
+            photog_make_image(output, Float32, width, height, layout));
+}
 
-    photog_chromadapt_impl(in, photog::get_gamma(working_space),
-                           photog::get_rgb_to_xyz_xfmr(working_space),
-                           photog::get_xyz_to_rgb_xfmr(working_space),
-                           transform, out);
+void photog_chromadapt_diy_u8(uint8_t *input, int width, int height,
+                              PhotogLayout layout,
+                              float *source_tristimulus,
+                              PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              float *dest_tristimulus, PhotogAccuracy accuracy,
+                              uint8_t *output) {
+    photog::chromadapt_diy<uint8_t>(
+            photog_make_image(input, Uint8, width, height, layout),
+            source_tristimulus, working_space, chromadapt_method,
+            dest_tristimulus, accuracy,
+            photog_make_image(output, Uint8, width, height, layout));
+}
+
+void photog_chromadapt_diy_u16(uint16_t *input, int width, int height,
+                               PhotogLayout layout,
+                               float *source_tristimulus,
+                               PhotogWorkingSpace working_space,
+                               PhotogChromadaptMethod chromadapt_method,
+                               float *dest_tristimulus, PhotogAccuracy accuracy,
+                               uint16_t *output) {
+    photog::chromadapt_diy<uint16_t>(
+            photog_make_image(input, Uint16, width, height, layout),
+            source_tristimulus, working_space, chromadapt_method,
+            dest_tristimulus, accuracy,
+            photog_make_image(output, Uint16, width, height, layout));
+}
+
+void photog_chromadapt_diy_f16(uint16_t *input, int width, int height,
+                               PhotogLayout layout,
+                               float *source_tristimulus,
+                               PhotogWorkingSpace working_space,
+                               PhotogChromadaptMethod chromadapt_method,
+                               float *dest_tristimulus, PhotogAccuracy accuracy,
+                               uint16_t *output) {
+    photog::chromadapt_diy<Halide::float16_t>(
+            photog_make_image(input, Float16, width, height, layout),
+            source_tristimulus, working_space, chromadapt_method,
+            dest_tristimulus, accuracy,
+            photog_make_image(output, Float16, width, height, layout));
 }
 
 void photog_chromadapt(float *input, int width, int height,
                        PhotogWorkingSpace working_space,
                        PhotogChromadaptMethod chromadapt_method,
                        PhotogIlluminant dest_illuminant, float *output) {
-    // TODO: Add way to use method other gray-world.
-    const int channels = 3;
-    Halide::Runtime::Buffer<float> in =
-            photog::get_buffer<float>(input, width, height, channels);
-    Halide::Runtime::Buffer<float> source_est(3);
+    photog_chromadapt_ex(input, width, height, PhotogLayout::IMAGE_LAYOUT,
+                         working_space, chromadapt_method, dest_illuminant,
+                         PhotogAccuracy::Exact, output);
+}
+
+void photog_chromadapt_ex(float *input, int width, int height,
+                          PhotogLayout layout,
+                          PhotogWorkingSpace working_space,
+                          PhotogChromadaptMethod chromadapt_method,
+                          PhotogIlluminant dest_illuminant,
+                          PhotogAccuracy accuracy, float *output) {
+    photog::chromadapt<float>(
+            photog_make_image(input, Float32, width, height, layout),
+            PhotogIlluminantEstimator::GrayWorld, working_space,
+            chromadapt_method, dest_illuminant, accuracy,
+            photog_make_image(output, Float32, width, height, layout));
+}
+
+void photog_chromadapt_u8(uint8_t *input, int width, int height,
+                          PhotogLayout layout,
+                          PhotogWorkingSpace working_space,
+                          PhotogChromadaptMethod chromadapt_method,
+                          PhotogIlluminant dest_illuminant,
+                          PhotogAccuracy accuracy, uint8_t *output) {
+    photog::chromadapt<uint8_t>(
+            photog_make_image(input, Uint8, width, height, layout),
+            PhotogIlluminantEstimator::GrayWorld, working_space,
+            chromadapt_method, dest_illuminant, accuracy,
+            photog_make_image(output, Uint8, width, height, layout));
+}
+
+void photog_chromadapt_u16(uint16_t *input, int width, int height,
+                           PhotogLayout layout,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy, uint16_t *output) {
+    photog::chromadapt<uint16_t>(
+            photog_make_image(input, Uint16, width, height, layout),
+            PhotogIlluminantEstimator::GrayWorld, working_space,
+            chromadapt_method, dest_illuminant, accuracy,
+            photog_make_image(output, Uint16, width, height, layout));
+}
+
+void photog_chromadapt_f16(uint16_t *input, int width, int height,
+                           PhotogLayout layout,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy, uint16_t *output) {
+    photog::chromadapt<Halide::float16_t>(
+            photog_make_image(input, Float16, width, height, layout),
+            PhotogIlluminantEstimator::GrayWorld, working_space,
+            chromadapt_method, dest_illuminant, accuracy,
+            photog_make_image(output, Float16, width, height, layout));
+}
+
+int photog_chromadapt_fused(float *input, int width, int height,
+                            PhotogLayout layout,
+                            int sample_factor,
+                            PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy, float *output) {
+    if (sample_factor < 1) {
+        std::cerr << "Unsupported sample factor " << sample_factor
+                  << " in photog_chromadapt_fused()." << std::endl;
+        abort();
+    }
+
+    photog::ChromadaptConstants constants =
+            photog::get_chromadapt_constants(working_space, chromadapt_method,
+                                             dest_illuminant);
+
+    return photog::chromadapt_fused<float>(
+            photog_make_image(input, Float32, width, height, layout),
+            sample_factor, constants, accuracy,
+            photog_make_image(output, Float32, width, height, layout));
+}
+
+void photog_chromadapt_diy_image(const PhotogImage *input,
+                                 float *source_tristimulus,
+                                 PhotogWorkingSpace working_space,
+                                 PhotogChromadaptMethod chromadapt_method,
+                                 float *dest_tristimulus,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output) {
+    photog::dispatch(input->type, [&](auto element) {
+        photog::chromadapt_diy<decltype(element)>(
+                *input, source_tristimulus, working_space, chromadapt_method,
+                dest_tristimulus, accuracy, *output);
+    });
+}
+
+void photog_chromadapt_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output) {
+    photog::dispatch(input->type, [&](auto element) {
+        photog::chromadapt<decltype(element)>(
+                *input, PhotogIlluminantEstimator::GrayWorld, working_space,
+                chromadapt_method, dest_illuminant, accuracy, *output);
+    });
+}
+
+void photog_chromadapt_estimator_image(const PhotogImage *input,
+                                       PhotogIlluminantEstimator estimator,
+                                       PhotogWorkingSpace working_space,
+                                       PhotogChromadaptMethod chromadapt_method,
+                                       PhotogIlluminant dest_illuminant,
+                                       PhotogAccuracy accuracy,
+                                       const PhotogImage *output) {
+    photog::dispatch(input->type, [&](auto element) {
+        photog::chromadapt<decltype(element)>(
+                *input, estimator, working_space, chromadapt_method,
+                dest_illuminant, accuracy, *output);
+    });
+}
 
-    photog_average(in, source_est);
+void photog_chromadapt_sampled_image(const PhotogImage *input,
+                                     int sample_factor,
+                                     PhotogWorkingSpace working_space,
+                                     PhotogChromadaptMethod chromadapt_method,
+                                     PhotogIlluminant dest_illuminant,
+                                     PhotogAccuracy accuracy,
+                                     const PhotogImage *output) {
+    if (sample_factor < 1) {
+        std::cerr << "Unsupported sample factor " << sample_factor
+                  << " in photog_chromadapt_sampled_image()." << std::endl;
+        abort();
+    }
+
+    std::array<float, 3> dest_tristimulus =
+            photog::get_tristimulus(dest_illuminant);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        Halide::Runtime::Buffer<float> source_est =
+                photog::estimate_illuminant_sampled<T>(*input, sample_factor,
+                                                       working_space);
+        photog::chromadapt_diy<T>(*input, source_est.data(), working_space,
+                                  chromadapt_method, dest_tristimulus.data(),
+                                  accuracy, *output);
+    });
+}
+
+void photog_estimate_illuminant(const PhotogImage *image,
+                                PhotogIlluminantEstimator estimator,
+                                PhotogWorkingSpace working_space,
+                                float *tristimulus) {
+    photog::dispatch(image->type, [&](auto element) {
+        Halide::Runtime::Buffer<float> estimate =
+                photog::estimate_illuminant<decltype(element)>(
+                        *image, estimator, working_space);
+        for (int c = 0; c < 3; ++c)
+            tristimulus[c] = estimate(c);
+    });
+}
+
+void photog_estimate_illuminant_sampled(const PhotogImage *image,
+                                        int sample_factor,
+                                        PhotogWorkingSpace working_space,
+                                        float *tristimulus,
+                                        PhotogSamplingReport *report) {
+    if (sample_factor < 1) {
+        std::cerr << "Unsupported sample factor " << sample_factor
+                  << " in photog_estimate_illuminant_sampled()." << std::endl;
+        abort();
+    }
+
+    photog::dispatch(image->type, [&](auto element) {
+        using T = decltype(element);
+        Halide::Runtime::Buffer<float> estimate =
+                photog::estimate_illuminant_sampled<T>(*image, sample_factor,
+                                                       working_space);
+        for (int c = 0; c < 3; ++c)
+            tristimulus[c] = estimate(c);
+
+        if (report)
+            *report = photog::get_sampling_report<T>(*image, sample_factor,
+                                                     working_space, estimate);
+    });
+}
+
+int photog_chromadapt_fused_image(const PhotogImage *input,
+                                  int sample_factor,
+                                  PhotogWorkingSpace working_space,
+                                  PhotogChromadaptMethod chromadapt_method,
+                                  PhotogIlluminant dest_illuminant,
+                                  PhotogAccuracy accuracy,
+                                  const PhotogImage *output) {
+    if (sample_factor < 1) {
+        std::cerr << "Unsupported sample factor " << sample_factor
+                  << " in photog_chromadapt_fused_image()." << std::endl;
+        abort();
+    }
+
+    photog::ChromadaptConstants constants =
+            photog::get_chromadapt_constants(working_space, chromadapt_method,
+                                             dest_illuminant);
+
+    int result{0};
+    photog::dispatch(input->type, [&](auto element) {
+        result = photog::chromadapt_fused<decltype(element)>(
+                *input, sample_factor, constants, accuracy, *output);
+    });
+
+    return result;
+}
+
+int photog_chromadapt_batch(const PhotogImage *inputs, int count,
+                            PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy,
+                            const PhotogImage *outputs) {
+    photog::ChromadaptConstants constants =
+            photog::get_chromadapt_constants(working_space, chromadapt_method,
+                                             dest_illuminant);
+    photog::ChromadaptBatch batch{inputs, outputs, &constants, accuracy};
+
+    // Images are adapted in parallel on Halide's thread pool. Each pipeline
+    // also parallelizes within its image on the same pool. The loop returns
+    // the first non-zero result of its tasks.
+    return halide_do_par_for(nullptr, photog::chromadapt_batch_task, 0, count,
+                             reinterpret_cast<uint8_t *>(&batch));
+}
+
+PhotogChromadaptPlan *
+photog_chromadapt_plan_create(PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              PhotogIlluminant dest_illuminant,
+                              PhotogAccuracy accuracy) {
+    return new PhotogChromadaptPlan{
+            photog::get_chromadapt_constants(working_space, chromadapt_method,
+                                             dest_illuminant),
+            accuracy};
+}
+
+int photog_chromadapt_plan_execute(PhotogChromadaptPlan *plan,
+                                   const PhotogImage *input,
+                                   const PhotogImage *output) {
+    int result{0};
+    photog::dispatch(input->type, [&](auto element) {
+        // Sampling every pixel matches photog_chromadapt's estimate.
+        result = photog::chromadapt_fused<decltype(element)>(
+                *input, 1, plan->constants, plan->accuracy, *output);
+    });
+
+    return result;
+}
+
+void photog_chromadapt_plan_destroy(PhotogChromadaptPlan *plan) {
+    delete plan;
+}
+
+PhotogVideoSession *
+photog_video_session_create(PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy, float smoothing,
+                            float drift_threshold) {
+    if (!(smoothing > 0.0f && smoothing <= 1.0f)) {
+        std::cerr << "Unsupported smoothing " << smoothing
+                  << " in photog_video_session_create()." << std::endl;
+        abort();
+    }
+    if (!(drift_threshold >= 0.0f)) {
+        std::cerr << "Unsupported drift threshold " << drift_threshold
+                  << " in photog_video_session_create()." << std::endl;
+        abort();
+    }
+
+    PhotogVideoReport report{};
+    report.sample_factor = 1;
+
+    return new PhotogVideoSession{
+            {working_space, chromadapt_method, accuracy, smoothing,
+             drift_threshold,
+             photog::copy_to_buffer(photog::get_tristimulus(dest_illuminant)),
+             Halide::Runtime::Buffer<float>(3),
+             Halide::Runtime::Buffer<float>(3),
+             Halide::Runtime::Buffer<float>(3, 3), 0, report}};
+}
+
+void photog_video_session_process(PhotogVideoSession *session,
+                                  const PhotogImage *input,
+                                  const PhotogImage *output) {
+    photog::dispatch(input->type, [&](auto element) {
+        photog::process_video_frame<decltype(element)>(session->state, *input,
+                                                       *output);
+    });
+}
+
+void photog_video_session_report(const PhotogVideoSession *session,
+                                 PhotogVideoReport *report) {
+    *report = session->state.report;
+}
+
+void photog_video_session_destroy(PhotogVideoSession *session) {
+    delete session;
+}
+
+int photog_chromadapt_stream(PhotogReadStrip read, PhotogWriteStrip write,
+                             void *user_context, int width, int height,
+                             PhotogElementType type, PhotogLayout layout,
+                             int strip_height,
+                             PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant,
+                             PhotogAccuracy accuracy) {
+    if (strip_height < 1) {
+        std::cerr << "Unsupported strip height " << strip_height
+                  << " in photog_chromadapt_stream()." << std::endl;
+        abort();
+    }
+
+    int result{0};
+    photog::dispatch(type, [&](auto element) {
+        result = photog::chromadapt_stream<decltype(element)>(
+                read, write, user_context, width, height, type, layout,
+                strip_height, working_space, chromadapt_method,
+                dest_illuminant, accuracy);
+    });
+
+    return result;
+}
+
+int photog_chromadapt_file(const char *input_path, const char *output_path,
+                           int strip_height,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy) {
+    photog::RawFiles files{std::ifstream{input_path, std::ios::binary},
+                           std::ofstream{output_path, std::ios::binary},
+                           0, 0};
+    if (!files.input || !files.output)
+        return 1;
+
+    photog::RawHeader header{};
+    files.input.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!files.input ||
+        std::memcmp(header.magic, photog::raw_magic,
+                    sizeof(photog::raw_magic)) != 0 ||
+        header.byte_order != photog::raw_byte_order_mark ||
+        header.channels != 3 ||
+        header.type > static_cast<uint32_t>(PhotogElementType::Float16) ||
+        header.layout > static_cast<uint32_t>(PhotogLayout::Interleaved) ||
+        header.width == 0 || header.height == 0 ||
+        header.width > INT32_MAX || header.height > INT32_MAX)
+        return 1;
+
+    // The adapted image has the same shape, so the header is copied as is.
+    files.output.write(reinterpret_cast<const char *>(&header),
+                       sizeof(header));
+    if (!files.output)
+        return 1;
+
+    auto type = static_cast<PhotogElementType>(header.type);
+    files.height = static_cast<int>(header.height);
+    photog::dispatch(type, [&](auto element) {
+        files.element_size = sizeof(element);
+    });
+
+    return photog_chromadapt_stream(photog::read_raw_strip,
+                                    photog::write_raw_strip, &files,
+                                    static_cast<int>(header.width),
+                                    files.height, type,
+                                    static_cast<PhotogLayout>(header.layout),
+                                    strip_height, working_space,
+                                    chromadapt_method, dest_illuminant,
+                                    accuracy);
+}
+
+void photog_srgb_to_linear_image(const PhotogImage *input,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::srgb_to_linear(input->alpha, layout,
+                                                          accuracy),
+                *input, *output);
+    });
+}
+
+void photog_srgb_to_linear_in_place(const PhotogImage *image,
+                                    PhotogAccuracy accuracy) {
+    photog_srgb_to_linear_image(image, accuracy, image);
+}
+
+void photog_linear_to_srgb_image(const PhotogImage *input,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::linear_to_srgb(input->alpha, layout,
+                                                          accuracy),
+                *input, *output);
+    });
+}
+
+void photog_linear_to_srgb_in_place(const PhotogImage *image,
+                                    PhotogAccuracy accuracy) {
+    photog_linear_to_srgb_image(image, accuracy, image);
+}
+
+void photog_rgb_to_linear_image(const PhotogImage *input,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy,
+                                const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+    float gamma = photog::get_gamma(working_space);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::rgb_to_linear(input->alpha, layout,
+                                                         accuracy),
+                *input, *output, gamma);
+    });
+}
+
+void photog_rgb_to_linear_in_place(const PhotogImage *image,
+                                   PhotogWorkingSpace working_space,
+                                   PhotogAccuracy accuracy) {
+    photog_rgb_to_linear_image(image, working_space, accuracy, image);
+}
+
+void photog_linear_to_rgb_image(const PhotogImage *input,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy,
+                                const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+    float gamma = photog::get_gamma(working_space);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::linear_to_rgb(input->alpha, layout,
+                                                         accuracy),
+                *input, *output, gamma);
+    });
+}
+
+void photog_linear_to_rgb_in_place(const PhotogImage *image,
+                                   PhotogWorkingSpace working_space,
+                                   PhotogAccuracy accuracy) {
+    photog_linear_to_rgb_image(image, working_space, accuracy, image);
+}
+
+void photog_srgb_to_xyz_image(const PhotogImage *input,
+                              PhotogAccuracy accuracy,
+                              const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::srgb_to_xyz(input->alpha, layout,
+                                                       accuracy),
+                *input, *output);
+    });
+}
+
+void photog_srgb_to_xyz_in_place(const PhotogImage *image,
+                                 PhotogAccuracy accuracy) {
+    photog_srgb_to_xyz_image(image, accuracy, image);
+}
+
+void photog_xyz_to_srgb_image(const PhotogImage *input,
+                              PhotogAccuracy accuracy,
+                              const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::xyz_to_srgb(input->alpha, layout,
+                                                       accuracy),
+                *input, *output);
+    });
+}
+
+void photog_xyz_to_srgb_in_place(const PhotogImage *image,
+                                 PhotogAccuracy accuracy) {
+    photog_xyz_to_srgb_image(image, accuracy, image);
+}
+
+void photog_rgb_to_xyz_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
     float gamma = photog::get_gamma(working_space);
     Halide::Runtime::Buffer<float> rgb_to_xyz_xfmr =
             photog::get_rgb_to_xyz_xfmr(working_space);
-    source_est = photog::rgb_to_xyz(source_est, gamma, rgb_to_xyz_xfmr);
 
-    std::array<float, 3> dest_tristimulus =
-            photog::get_tristimulus(dest_illuminant);
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::rgb_to_xyz(input->alpha, layout,
+                                                      accuracy),
+                *input, *output, gamma, rgb_to_xyz_xfmr);
+    });
+}
+
+void photog_rgb_to_xyz_in_place(const PhotogImage *image,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy) {
+    photog_rgb_to_xyz_image(image, working_space, accuracy, image);
+}
+
+void photog_xyz_to_rgb_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output) {
+    PhotogLayout layout = photog::get_layout(*input, *output);
+    float gamma = photog::get_gamma(working_space);
+    Halide::Runtime::Buffer<float> xyz_to_rgb_xfmr =
+            photog::get_xyz_to_rgb_xfmr(working_space);
+
+    photog::dispatch(input->type, [&](auto element) {
+        using T = decltype(element);
+        photog::convert<T>(
+                photog::ColorLibraries<T>::xyz_to_rgb(input->alpha, layout,
+                                                      accuracy),
+                *input, *output, gamma, xyz_to_rgb_xfmr);
+    });
+}
+
+void photog_xyz_to_rgb_in_place(const PhotogImage *image,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy) {
+    photog_xyz_to_rgb_image(image, working_space, accuracy, image);
+}
+
+void photog_image_statistics(const PhotogImage *image,
+                             PhotogImageStatistics *statistics) {
+    photog::dispatch(image->type, [&](auto element) {
+        photog::image_statistics<decltype(element)>(*image, *statistics);
+    });
+}
+
+float photog_statistics_percentile(const PhotogImageStatistics *statistics,
+                                   int channel, float percentile) {
+    if (channel < 0 || channel > 2) {
+        std::cerr << "Unsupported channel " << channel
+                  << " in photog_statistics_percentile()." << std::endl;
+        abort();
+    }
+
+    const int bins{PHOTOG_HISTOGRAM_BINS};
+    const uint32_t *histogram = statistics->histogram[channel];
+    uint64_t total{0};
+    for (int b = 0; b < bins; ++b)
+        total += histogram[b];
+    if (total == 0)
+        return 0.0f;
+
+    double target = std::clamp(percentile, 0.0f, 100.0f) / 100.0 * total;
+    double cumulative{0};
+    for (int b = 0; b < bins; ++b) {
+        if (histogram[b] > 0 && cumulative + histogram[b] >= target) {
+            double fraction = (target - cumulative) / histogram[b];
+            auto value = static_cast<float>((b + fraction) / bins);
+            return std::clamp(value, statistics->min[channel],
+                              statistics->max[channel]);
+        }
+        cumulative += histogram[b];
+    }
+
+    return statistics->max[channel];
+}
+
+PhotogLut *photog_lut_bake(int size, PhotogLutTransform transform,
+                           void *user_context) {
+    if (size < 2) {
+        std::cerr << "Unsupported lookup table size " << size
+                  << " in photog_lut_bake()." << std::endl;
+        abort();
+    }
+
+    const int width{size * size}, channels{3};
+    std::vector<float> grid_storage(static_cast<size_t>(width) * size *
+                                    channels);
+    Halide::Runtime::Buffer<float> grid =
+            photog::get_buffer<float>(grid_storage.data(), width, size,
+                                      channels, PhotogLayout::Planar);
+    const float last = static_cast<float>(size - 1);
+    for (int b = 0; b < size; ++b) {
+        for (int g = 0; g < size; ++g) {
+            for (int r = 0; r < size; ++r) {
+                grid(r + size * g, b, 0) = r / last;
+                grid(r + size * g, b, 1) = g / last;
+                grid(r + size * g, b, 2) = b / last;
+            }
+        }
+    }
+
+    auto lut = new PhotogLut{size,
+                             std::vector<float>(grid_storage.size())};
+    PhotogImage input = photog_make_image(grid_storage.data(), Float32, width,
+                                          size, PhotogLayout::Planar);
+    PhotogImage output = photog_make_image(lut->samples.data(), Float32,
+                                           width, size, PhotogLayout::Planar);
+    transform(user_context, &input, &output);
+
+    return lut;
+}
+
+void photog_lut_apply(const PhotogLut *lut, const PhotogImage *input,
+                      const PhotogImage *output) {
+    photog::dispatch(input->type, [&](auto element) {
+        photog::apply_lut<decltype(element)>(lut->size, lut->samples.data(),
+                                             *input, *output);
+    });
+}
 
-    photog_chromadapt_diy(input, width, height, source_est.data(),
-                          working_space, chromadapt_method,
-                          dest_tristimulus.data(), output);
+void photog_lut_destroy(PhotogLut *lut) {
+    delete lut;
 }
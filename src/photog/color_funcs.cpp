@@ -0,0 +1,662 @@
+#include "color_funcs.h"
+
+#include <cstdint>
+#include <iostream>
+
+#include "Halide.h"
+
+#include "photog/color.h"
+
+namespace photog {
+    /** Largest value of an unsigned integer type as a float.*/
+    float max_value(const Halide::Type &type) {
+        if (!type.is_uint()) {
+            std::cerr << "Unsupported image type " << type
+                      << " in photog::max_value()." << std::endl;
+            abort();
+        }
+
+        return static_cast<float>((uint64_t{1} << type.bits()) - 1);
+    }
+
+    /** Converts an image value to a float. Integer values are scaled from
+     * their type's full range to between 0 and 1.*/
+    Halide::Expr normalize(const Halide::Expr &value) {
+        Halide::Type type = value.type();
+
+        if (type.is_float())
+            return Halide::cast<float>(value);
+        else
+            return Halide::cast<float>(value) * (1.0f / max_value(type));
+    }
+
+    /** Converts a float between 0 and 1 to an image value of the given type.
+     * Integer values are rounded and saturated to their type's full range.*/
+    Halide::Expr quantize(const Halide::Expr &value, const Halide::Type &type) {
+        if (type.is_float())
+            return Halide::cast(type, value);
+        else
+            return Halide::saturating_cast(type,
+                                           Halide::round(value *
+                                                         max_value(type)));
+    }
+
+    /** Factor that XYZ values are multiplied by when stored as values of the
+     * given type. Integer images hold scaled values, so that values up to
+     * 1 / PHOTOG_INTEGER_XYZ_SCALE fit their type's range.*/
+    float xyz_scale(const Halide::Type &type) {
+        return type.is_float() ? 1.0f : PHOTOG_INTEGER_XYZ_SCALE;
+    }
+
+    /** Image with values normalized to floats.*/
+    Halide::Func normalized(const Halide::Func &image) {
+        Halide::Func normalized{"normalized"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        normalized(x, y, c) = photog::normalize(image(x, y, c));
+
+        return normalized;
+    }
+
+    /** Color channels of an image normalized to floats.
+     *
+     * Premultiplied colors are divided by alpha so that they may be
+     * processed as straight colors. Fully transparent pixels are left as
+     * they are.*/
+    Halide::Func colors(const Halide::Func &image, PhotogAlpha alpha) {
+        Halide::Func colors{"colors"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+        Halide::Expr color = photog::normalize(image(x, y, c));
+
+        if (alpha == PhotogAlpha::Premultiplied) {
+            Halide::Expr a = photog::normalize(image(x, y, 3));
+            color = color / Halide::select(a == 0.0f, 1.0f, a);
+        }
+        colors(x, y, c) = color;
+
+        return colors;
+    }
+
+    /** Image of the given type holding processed colors followed by the
+     * alpha channel of the image they came from, if any.
+     *
+     * Colors are floats between 0 and 1. Premultiplied colors are multiplied
+     * by alpha again. Alpha is copied without conversion.*/
+    Halide::Func
+    with_alpha(const Halide::Func &colors, const Halide::Func &image,
+               const Halide::Type &type, PhotogAlpha alpha) {
+        Halide::Func with_alpha{"with_alpha"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        if (alpha == PhotogAlpha::Opaque) {
+            with_alpha(x, y, c) = photog::quantize(colors(x, y, c), type);
+            return with_alpha;
+        }
+
+        Halide::Expr color = colors(x, y, Halide::min(c, 2));
+        if (alpha == PhotogAlpha::Premultiplied)
+            color = color * photog::normalize(image(x, y, 3));
+        with_alpha(x, y, c) = Halide::select(c < 3,
+                                             photog::quantize(color, type),
+                                             Halide::cast(type,
+                                                          image(x, y, 3)));
+
+        return with_alpha;
+    }
+
+    /** Height in rows of the strips that image sums are split into.*/
+    const int strip_height{32};
+
+    /** Type used to accumulate sums of image_type values.*/
+    Halide::Type accumulator_type(const Halide::Type &image_type) {
+        if (image_type.bits() != 64)
+            return image_type.widen();
+        else
+            return image_type;
+    }
+
+    /** Sums each channel of an image over fixed-height strips of rows.
+     *
+     * Strip height does not depend on the number of threads that strips are
+     * distributed across. Summation order, and hence the result, is therefore
+     * the same regardless of how the strips are scheduled.*/
+    Halide::Func
+    strip_sums(const Halide::Func &image, const Halide::Type &sum_type,
+               const Halide::Expr &width, const Halide::Expr &height) {
+        Halide::Func strip_sum{"func_strip_sum"};
+        Halide::Var s{"func_s"}, c{"func_c"};
+        Halide::RDom r{0, width, 0, strip_height};
+        Halide::Expr y = s * strip_height + r.y;
+        r.where(y < height);
+
+        strip_sum(s, c) = Halide::cast(sum_type, 0);
+        strip_sum(s, c) += Halide::cast(sum_type, image(r.x, y, c));
+
+        return strip_sum;
+    }
+
+    /** Calculates average pixel value for an image from its strip sums.*/
+    Halide::Func
+    average_strip_sums(const Halide::Func &strip_sum,
+                       const Halide::Type &image_type,
+                       const Halide::Expr &width, const Halide::Expr &height,
+                       const Halide::Expr &channels) {
+        Halide::Func average{"func_average"}, sum{"func_sum"};
+        Halide::Var c{"func_c"};
+        Halide::RDom r{0, (height + strip_height - 1) / strip_height};
+        Halide::Type wide = accumulator_type(image_type);
+
+        // Strips are summed serially and in order to keep the result
+        // deterministic.
+        sum(c) = Halide::cast(wide, 0);
+        sum(c) += strip_sum(r, c);
+        average(c) = Halide::cast(image_type,
+                                  sum(c) / (width * height * channels));
+
+        return average;
+    }
+
+    /** Calculates average pixel value for an image.*/
+    Halide::Func
+    average(const Halide::Func &image, const Halide::Type &image_type,
+            const Halide::Expr &width, const Halide::Expr &height,
+            const Halide::Expr &channels) {
+        Halide::Func strip_sum =
+                photog::strip_sums(image, accumulator_type(image_type), width,
+                                   height);
+
+        return photog::average_strip_sums(strip_sum, image_type, width,
+                                          height, channels);
+    }
+
+    /** Strided grid of an image holding every sample_factor-th pixel in
+     * each dimension, starting from the first.*/
+    Halide::Func
+    sampled(const Halide::Func &image, const Halide::Expr &sample_factor) {
+        Halide::Func sampled{"func_sampled"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        sampled(x, y, c) = image(x * sample_factor, y * sample_factor, c);
+
+        return sampled;
+    }
+
+    /** Gathers the statistics of each channel of a float image that
+     * illuminant estimators other than gray-world need, over fixed-height
+     * strips of rows.
+     *
+     * Each strip holds a tuple of the maximum, sum of norm-th powers and sum
+     * of norm-th powers of gradient magnitudes of its values. All are updated
+     * together so that the image is read once. Gradients are forward
+     * differences, clamped at the image's edges.*/
+    Halide::Func
+    strip_statistics(const Halide::Func &image, const Halide::Type &sum_type,
+                     const Halide::Expr &width, const Halide::Expr &height,
+                     const Halide::Expr &norm) {
+        Halide::Func strip_stats{"func_strip_statistics"};
+        Halide::Var s{"func_s"}, c{"func_c"};
+        Halide::RDom r{0, width, 0, strip_height};
+        Halide::Expr y = s * strip_height + r.y;
+        r.where(y < height);
+
+        Halide::Expr value = image(r.x, y, c);
+        Halide::Expr dx = image(Halide::min(r.x + 1, width - 1), y, c) - value;
+        Halide::Expr dy = image(r.x, Halide::min(y + 1, height - 1), c) - value;
+        Halide::Expr edge = Halide::sqrt(dx * dx + dy * dy);
+        Halide::Expr zero = Halide::cast(sum_type, 0);
+
+        strip_stats(s, c) = {0.0f, zero, zero};
+        strip_stats(s, c) = {
+                Halide::max(strip_stats(s, c)[0], value),
+                strip_stats(s, c)[1] +
+                Halide::cast(sum_type, Halide::pow(value, norm)),
+                strip_stats(s, c)[2] +
+                Halide::cast(sum_type, Halide::pow(edge, norm))};
+
+        return strip_stats;
+    }
+
+    /** Combines strip statistics into one estimate per channel for each
+     * PhotogIlluminantEstimator from WhitePatch on, indexed by channel and
+     * then estimator - WhitePatch.
+     *
+     * Means are taken over the elements of all three channels, as by
+     * average(), so that shades-of-gray with a norm of 1 is gray-world.*/
+    Halide::Func
+    illuminant_statistics(const Halide::Func &strip_statistics,
+                          const Halide::Type &sum_type,
+                          const Halide::Expr &width,
+                          const Halide::Expr &height,
+                          const Halide::Expr &norm) {
+        Halide::Func statistics{"func_illuminant_statistics"},
+                total{"func_total"};
+        Halide::Var c{"func_c"}, e{"func_e"};
+        Halide::RDom r{0, (height + strip_height - 1) / strip_height};
+        Halide::Expr zero = Halide::cast(sum_type, 0);
+        Halide::Expr count = Halide::cast(sum_type, width) * height * 3;
+
+        // Strips are combined serially and in order to keep the result
+        // deterministic.
+        total(c) = {0.0f, zero, zero};
+        total(c) = {Halide::max(total(c)[0], strip_statistics(r, c)[0]),
+                    total(c)[1] + strip_statistics(r, c)[1],
+                    total(c)[2] + strip_statistics(r, c)[2]};
+
+        Halide::Expr estimator = e + PhotogIlluminantEstimator::WhitePatch;
+        Halide::Expr inverse_norm = Halide::cast(sum_type, 1.0f / norm);
+        statistics(c, e) = Halide::cast<float>(
+                Halide::select(estimator ==
+                               PhotogIlluminantEstimator::WhitePatch,
+                               Halide::cast(sum_type, total(c)[0]),
+                               estimator ==
+                               PhotogIlluminantEstimator::ShadesOfGray,
+                               Halide::pow(total(c)[1] / count, inverse_norm),
+                               Halide::pow(total(c)[2] / count,
+                                           inverse_norm)));
+
+        return statistics;
+    }
+
+    /** Histogram slot of a float value. Slot 0 holds values of 0 or less,
+     * slots 1 to bins hold equal-width bins between 0 and 1, and slot
+     * bins + 1 holds values of 1 or more.*/
+    Halide::Expr histogram_slot(const Halide::Expr &value, int bins) {
+        return Halide::select(
+                value <= 0.0f, 0,
+                value >= 1.0f, bins + 1,
+                1 + Halide::clamp(Halide::cast<int>(value * bins), 0,
+                                  bins - 1));
+    }
+
+    /** Fills a partial histogram of each channel for each fixed-height strip
+     * of rows.
+     *
+     * binned holds the histogram slot and value of each element. Each slot
+     * holds a tuple of its count and the minimum and maximum of its values,
+     * so that extrema are found in the same read as counts. Strips fill
+     * separate histograms so that they may be filled in parallel.*/
+    Halide::Func
+    strip_histograms(const Halide::Func &binned, int bins,
+                     const Halide::Expr &width, const Halide::Expr &height) {
+        Halide::Func strip_histogram{"func_strip_histogram"};
+        Halide::Var b{"func_b"}, s{"func_s"}, c{"func_c"};
+        Halide::RDom r{0, width, 0, strip_height};
+        Halide::Expr y = s * strip_height + r.y;
+        r.where(y < height);
+
+        Halide::Expr slot = Halide::clamp(binned(r.x, y, c)[0], 0, bins + 1);
+        Halide::Expr value = binned(r.x, y, c)[1];
+
+        strip_histogram(b, s, c) = {Halide::cast<uint32_t>(0),
+                                    Halide::Float(32).max(),
+                                    Halide::Float(32).min()};
+        strip_histogram(slot, s, c) = {
+                strip_histogram(slot, s, c)[0] + 1,
+                Halide::min(strip_histogram(slot, s, c)[1], value),
+                Halide::max(strip_histogram(slot, s, c)[2], value)};
+
+        return strip_histogram;
+    }
+
+    /** Merges the partial histograms of each strip of an image.*/
+    Halide::Func
+    merge_histograms(const Halide::Func &strip_histograms,
+                     const Halide::Expr &height) {
+        Halide::Func histogram{"func_histogram"};
+        Halide::Var b{"func_b"}, c{"func_c"};
+        Halide::RDom r{0, (height + strip_height - 1) / strip_height};
+
+        histogram(b, c) = {Halide::cast<uint32_t>(0),
+                           Halide::Float(32).max(),
+                           Halide::Float(32).min()};
+        histogram(b, c) = {
+                histogram(b, c)[0] + strip_histograms(b, r, c)[0],
+                Halide::min(histogram(b, c)[1], strip_histograms(b, r, c)[1]),
+                Halide::max(histogram(b, c)[2], strip_histograms(b, r, c)[2])};
+
+        return histogram;
+    }
+
+    /** Approximates log2(x) for x > 0.
+     *
+     * x is split into its exponent and a mantissa m in [1, 2). log2(m) is
+     * approximated by a degree-6 polynomial with a maximum absolute error of
+     * 2.1e-6.*/
+    Halide::Expr fast_log2(const Halide::Expr &x) {
+        Halide::Expr bits = Halide::reinterpret(Halide::Int(32), x);
+        Halide::Expr exponent = (bits >> 23) - 127;
+        Halide::Expr mantissa =
+                Halide::reinterpret(Halide::Float(32),
+                                    (bits & 0x007fffff) | 0x3f800000);
+        Halide::Expr t = mantissa - 1.0f;
+        Halide::Expr polynomial =
+                1.44255314f + t * (-0.718281906f + t * (0.458270748f +
+                t * (-0.279538022f + t * (0.123451381f +
+                t * -0.0264574134f))));
+
+        return Halide::cast<float>(exponent) + t * polynomial;
+    }
+
+    /** Approximates 2^x for x in [-126, 127].
+     *
+     * x is split into an integer part, applied through the exponent bits of
+     * the result, and a fractional part f in [0, 1). 2^f is approximated by a
+     * degree-5 polynomial with a maximum relative error of 7.5e-8.*/
+    Halide::Expr fast_exp2(const Halide::Expr &x) {
+        Halide::Expr clamped = Halide::clamp(x, -126.0f, 127.0f);
+        Halide::Expr integer = Halide::floor(clamped);
+        Halide::Expr f = clamped - integer;
+        Halide::Expr scale =
+                Halide::reinterpret(Halide::Float(32),
+                                    (Halide::cast<int>(integer) + 127) << 23);
+        Halide::Expr polynomial =
+                0.999999925f + f * (0.693153073f + f * (0.240153617f +
+                f * (0.0558263179f + f * (0.00898934025f +
+                f * 0.00187757661f))));
+
+        return scale * polynomial;
+    }
+
+    /** Raises x to the power of y at the given accuracy.
+     *
+     * The fast tier evaluates 2^(y * log2(x)) with polynomial approximations
+     * that vectorize cleanly. Over x in [0, 1], sRGB transfer functions and
+     * gamma 2.2 (and its inverse) stay within 3.7e-6 of exact results: less
+     * than 0.25 LSB at 16 bits. Error grows in proportion to y. Values of
+     * x <= 0 give 0.*/
+    Halide::Expr transfer_pow(const Halide::Expr &x, const Halide::Expr &y,
+                              PhotogAccuracy accuracy) {
+        if (accuracy == PhotogAccuracy::Fast)
+            return Halide::select(x > 0.0f,
+                                  photog::fast_exp2(y * photog::fast_log2(x)),
+                                  0.0f);
+        else
+            return Halide::pow(x, y);
+    }
+
+    Halide::Expr
+    srgb_to_linear(const Halide::Expr &channel, PhotogAccuracy accuracy) {
+        return Halide::select(channel <= 0.04045f,
+                              channel / 12.92f,
+                              photog::transfer_pow((channel + 0.055f) / 1.055f,
+                                                   2.4f, accuracy));
+    }
+
+    Halide::Expr
+    linear_to_srgb(const Halide::Expr &channel, PhotogAccuracy accuracy) {
+        return Halide::select(channel <= 0.0031308f,
+                              channel * 12.92f,
+                              (1.055f * photog::transfer_pow(channel, 1 / 2.4f,
+                                                             accuracy)) -
+                              0.055f);
+    }
+
+    Halide::Expr
+    rgb_to_linear(const Halide::Expr &channel, const Halide::Expr &gamma,
+                  PhotogAccuracy accuracy) {
+        return photog::transfer_pow(channel, gamma, accuracy);
+    }
+
+    Halide::Expr
+    linear_to_rgb(const Halide::Expr &channel, const Halide::Expr &gamma,
+                  PhotogAccuracy accuracy) {
+        return photog::transfer_pow(channel, 1 / gamma, accuracy);
+    }
+
+    Halide::Func
+    rgb_to_xyz(const Halide::Func &rgb, const Halide::Expr &gamma,
+               const Halide::Func &rgb_to_xyz_xfmr, PhotogAccuracy accuracy) {
+        Halide::Func linear{"linear"}, xyz{"xyz"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        linear(x, y, c) = photog::rgb_to_linear(rgb(x, y, c), gamma, accuracy);
+        xyz(x, y, c) = rgb_to_xyz_xfmr(0, c) * linear(x, y, 0) +
+                       rgb_to_xyz_xfmr(1, c) * linear(x, y, 1) +
+                       rgb_to_xyz_xfmr(2, c) * linear(x, y, 2);
+
+        return xyz;
+    }
+
+    Halide::Func
+    xyz_to_rgb(const Halide::Func &xyz, const Halide::Expr &gamma,
+               const Halide::Func &xyz_to_rgb_xfmr, PhotogAccuracy accuracy) {
+        Halide::Func linear{"linear"}, rgb{"rgb"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        linear(x, y, c) = xyz_to_rgb_xfmr(0, c) * xyz(x, y, 0) +
+                          xyz_to_rgb_xfmr(1, c) * xyz(x, y, 1) +
+                          xyz_to_rgb_xfmr(2, c) * xyz(x, y, 2);
+
+        rgb(x, y, c) = Halide::clamp(linear_to_rgb(linear(x, y, c), gamma,
+                                                   accuracy),
+                                     0.0f, 1.0f);
+
+        return rgb;
+    }
+
+    /** Chromatically adapts RGB input using a transform between XYZ values
+     * under source and destination illuminants.*/
+    Halide::Func
+    chromadapt(const Halide::Func &rgb, const Halide::Expr &gamma,
+               const Halide::Func &rgb_to_xyz_xfmr,
+               const Halide::Func &xyz_to_rgb_xfmr,
+               const Halide::Func &transform, PhotogAccuracy accuracy) {
+        Halide::Func adapted{"adapted"}, xyz{"xyz"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        xyz(x, y, c) = photog::rgb_to_xyz(rgb, gamma, rgb_to_xyz_xfmr,
+                                          accuracy)(x, y, c);
+
+        adapted(x, y, c) =
+                transform(0, c) * xyz(x, y, 0) +
+                transform(1, c) * xyz(x, y, 1) +
+                transform(2, c) * xyz(x, y, 2);
+
+        return photog::xyz_to_rgb(adapted, gamma, xyz_to_rgb_xfmr, accuracy);
+    }
+
+    /** Chromatically adapts RGB input using a single transform that takes
+     * linear RGB values under a source illuminant to a destination
+     * illuminant.
+     *
+     * Equivalent to photog::chromadapt with transform folded between the
+     * RGB/XYZ transforms, saving two 3x3 matrix multiplies per pixel.*/
+    Halide::Func
+    chromadapt_folded(const Halide::Func &rgb, const Halide::Expr &gamma,
+                      const Halide::Func &rgb_transform,
+                      PhotogAccuracy accuracy) {
+        Halide::Func linear{"linear"}, adapted{"adapted"}, output{"output"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        linear(x, y, c) = photog::rgb_to_linear(rgb(x, y, c), gamma, accuracy);
+
+        adapted(x, y, c) =
+                rgb_transform(0, c) * linear(x, y, 0) +
+                rgb_transform(1, c) * linear(x, y, 1) +
+                rgb_transform(2, c) * linear(x, y, 2);
+
+        output(x, y, c) =
+                Halide::clamp(photog::linear_to_rgb(adapted(x, y, c), gamma,
+                                                    accuracy),
+                              0.0f, 1.0f);
+
+        return output;
+    }
+
+    /** Composes 3x3 transforms held in (column, row) order so that b is
+     * applied first.*/
+    Halide::Func compose_xfmrs(const Halide::Func &a, const Halide::Func &b) {
+        Halide::Func output{"composed_xfmr"};
+        Halide::Var i{"i"}, j{"j"};
+
+        output(j, i) = a(0, i) * b(j, 0) +
+                       a(1, i) * b(j, 1) +
+                       a(2, i) * b(j, 2);
+
+        return output;
+    }
+
+    /** Calculates the transform between XYZ values under source and
+     * destination illuminants.
+     *
+     * Mirrors photog::create_transform for use within a pipeline.*/
+    Halide::Func
+    chromadapt_transform(const Halide::Func &source_tristimulus,
+                         const Halide::Func &dest_tristimulus,
+                         const Halide::Func &xyz_to_lms_xfmr,
+                         const Halide::Func &lms_to_xyz_xfmr) {
+        Halide::Func lms_source{"lms_source"}, lms_dest{"lms_dest"},
+                lms_gain{"lms_gain"}, transform{"transform"};
+        Halide::Var i{"i"}, j{"j"};
+
+        // Tristimulus values are normalized to Y = 100.
+        lms_source(i) = (xyz_to_lms_xfmr(0, i) * source_tristimulus(0) +
+                         xyz_to_lms_xfmr(1, i) * source_tristimulus(1) +
+                         xyz_to_lms_xfmr(2, i) * source_tristimulus(2)) *
+                        (100.0f / source_tristimulus(1));
+        lms_dest(i) = (xyz_to_lms_xfmr(0, i) * dest_tristimulus(0) +
+                       xyz_to_lms_xfmr(1, i) * dest_tristimulus(1) +
+                       xyz_to_lms_xfmr(2, i) * dest_tristimulus(2)) *
+                      (100.0f / dest_tristimulus(1));
+        lms_gain(i) = lms_dest(i) / lms_source(i);
+
+        // lms_to_xyz_xfmr * diagonal(lms_gain) * xyz_to_lms_xfmr
+        transform(j, i) =
+                lms_to_xyz_xfmr(0, i) * lms_gain(0) * xyz_to_lms_xfmr(j, 0) +
+                lms_to_xyz_xfmr(1, i) * lms_gain(1) * xyz_to_lms_xfmr(j, 1) +
+                lms_to_xyz_xfmr(2, i) * lms_gain(2) * xyz_to_lms_xfmr(j, 2);
+
+        return transform;
+    }
+
+    /** Folds the chromatic adaptation of RGB images from a source illuminant,
+     * given as the gray-world average of an image, to a destination
+     * illuminant into a single 3x3 transform of linear RGB values.*/
+    Halide::Func
+    gray_world_xfmr(const Halide::Func &source_rgb, const Halide::Expr &gamma,
+                    const Halide::Func &rgb_to_xyz_xfmr,
+                    const Halide::Func &xyz_to_rgb_xfmr,
+                    const Halide::Func &xyz_to_lms_xfmr,
+                    const Halide::Func &lms_to_xyz_xfmr,
+                    const Halide::Func &dest_tristimulus,
+                    PhotogAccuracy accuracy) {
+        Halide::Func source_image{"source_image"}, source_xyz{"source_xyz"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+
+        source_image(x, y, c) = source_rgb(c);
+        source_xyz(c) = photog::rgb_to_xyz(source_image, gamma,
+                                           rgb_to_xyz_xfmr,
+                                           accuracy)(0, 0, c);
+
+        Halide::Func transform =
+                photog::chromadapt_transform(source_xyz, dest_tristimulus,
+                                             xyz_to_lms_xfmr,
+                                             lms_to_xyz_xfmr);
+
+        // Folded once per call so that each pixel takes a single 3x3
+        // multiply.
+        return photog::compose_xfmrs(
+                xyz_to_rgb_xfmr,
+                photog::compose_xfmrs(transform, rgb_to_xyz_xfmr));
+    }
+
+    /** Estimates the source illuminant of an image with the gray-world method
+     * and chromatically adapts the image to a destination illuminant.
+     *
+     * The estimate is taken from every sample_factor-th pixel in each
+     * dimension. Output values are floats between 0 and 1.*/
+    Halide::Func
+    chromadapt_gray_world(const Halide::Func &image, const Halide::Expr &width,
+                          const Halide::Expr &height,
+                          const Halide::Expr &channels,
+                          const Halide::Expr &sample_factor,
+                          const Halide::Expr &gamma,
+                          const Halide::Func &rgb_to_xyz_xfmr,
+                          const Halide::Func &xyz_to_rgb_xfmr,
+                          const Halide::Func &xyz_to_lms_xfmr,
+                          const Halide::Func &lms_to_xyz_xfmr,
+                          const Halide::Func &dest_tristimulus,
+                          PhotogAccuracy accuracy) {
+        Halide::Func sample{"sample"}, source_rgb{"source_rgb"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+        Halide::Expr sample_width = (width - 1) / sample_factor + 1;
+        Halide::Expr sample_height = (height - 1) / sample_factor + 1;
+
+        Halide::Func normalized = photog::normalized(image);
+        sample(x, y, c) = photog::sampled(normalized, sample_factor)(x, y, c);
+        source_rgb(c) = photog::average(sample, Halide::Float(32),
+                                        sample_width, sample_height,
+                                        channels)(c);
+
+        Halide::Func rgb_transform =
+                photog::gray_world_xfmr(source_rgb, gamma, rgb_to_xyz_xfmr,
+                                        xyz_to_rgb_xfmr, xyz_to_lms_xfmr,
+                                        lms_to_xyz_xfmr, dest_tristimulus,
+                                        accuracy);
+
+        return photog::chromadapt_folded(normalized, gamma, rgb_transform,
+                                         accuracy);
+    }
+
+    /** Applies a 3D lookup table to RGB input with tetrahedral
+     * interpolation.
+     *
+     * lut holds (r, g, b, c) samples of a transform on a size^3 grid spanning
+     * 0 to 1 in each channel. Input is clamped to that range. Each pixel
+     * lies in a cube of the grid that is split into six tetrahedra along its
+     * diagonal. The tetrahedron holding the pixel is picked by ordering its
+     * fractional offsets, and the pixel is weighted between four corners:
+     * the cube's first and last corners and two corners stepped along the
+     * axes of its largest offsets. Corners are chosen with selects so that
+     * every pixel takes the same four gathers and vectorizes cleanly.*/
+    Halide::Func
+    apply_lut(const Halide::Func &rgb, const Halide::Func &lut,
+              const Halide::Expr &size) {
+        Halide::Func position{"lut_position"}, output{"output"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+        Halide::Expr last = size - 1;
+
+        // Cube index and offset within the cube for each channel. Values of
+        // 1 fall in the last cube with an offset of 1.
+        Halide::Expr scaled =
+                Halide::clamp(rgb(x, y, c), 0.0f, 1.0f) *
+                Halide::cast<float>(last);
+        Halide::Expr cube = Halide::clamp(Halide::cast<int>(scaled), 0,
+                                          last - 1);
+        position(x, y, c) = {cube, scaled - Halide::cast<float>(cube)};
+
+        Halide::Expr r = position(x, y, 0)[0], g = position(x, y, 1)[0],
+                b = position(x, y, 2)[0];
+        Halide::Expr fr = position(x, y, 0)[1], fg = position(x, y, 1)[1],
+                fb = position(x, y, 2)[1];
+
+        // Axes of the largest and smallest offsets. Ties pick distinct axes
+        // whose corners are weighted by zero.
+        Halide::Expr r_gt_g = fr > fg, g_gt_b = fg > fb, r_gt_b = fr > fb;
+        Halide::Expr high = Halide::select(r_gt_g,
+                                           Halide::select(r_gt_b, 0, 2),
+                                           Halide::select(g_gt_b, 1, 2));
+        Halide::Expr low = Halide::select(r_gt_g,
+                                          Halide::select(g_gt_b, 2, 1),
+                                          Halide::select(r_gt_b, 2, 0));
+        Halide::Expr f_high = Halide::max(fr, Halide::max(fg, fb));
+        Halide::Expr f_low = Halide::min(fr, Halide::min(fg, fb));
+        Halide::Expr f_middle = fr + fg + fb - f_high - f_low;
+
+        // Second corner steps along the largest axis. Third steps along all
+        // but the smallest.
+        Halide::Expr second = lut(r + Halide::select(high == 0, 1, 0),
+                                  g + Halide::select(high == 1, 1, 0),
+                                  b + Halide::select(high == 2, 1, 0), c);
+        Halide::Expr third = lut(r + Halide::select(low == 0, 0, 1),
+                                 g + Halide::select(low == 1, 0, 1),
+                                 b + Halide::select(low == 2, 0, 1), c);
+
+        output(x, y, c) = (1.0f - f_high) * lut(r, g, b, c) +
+                          (f_high - f_middle) * second +
+                          (f_middle - f_low) * third +
+                          f_low * lut(r + 1, g + 1, b + 1, c);
+
+        return output;
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef PHOTOG_COLOR_FUNCS_H
+#define PHOTOG_COLOR_FUNCS_H
+
+#include "Halide.h"
+
+#include "photog/color.h"
+
+namespace photog {
+    float max_value(const Halide::Type &type);
+
+    Halide::Expr normalize(const Halide::Expr &value);
+
+    Halide::Expr quantize(const Halide::Expr &value, const Halide::Type &type);
+
+    float xyz_scale(const Halide::Type &type);
+
+    Halide::Func normalized(const Halide::Func &image);
+
+    Halide::Func colors(const Halide::Func &image, PhotogAlpha alpha);
+
+    Halide::Func
+    with_alpha(const Halide::Func &colors, const Halide::Func &image,
+               const Halide::Type &type, PhotogAlpha alpha);
+
+    Halide::Type accumulator_type(const Halide::Type &image_type);
+
+    Halide::Func
+    strip_sums(const Halide::Func &image, const Halide::Type &sum_type,
+               const Halide::Expr &width, const Halide::Expr &height);
+
+    Halide::Func
+    average_strip_sums(const Halide::Func &strip_sum,
+                       const Halide::Type &image_type,
+                       const Halide::Expr &width, const Halide::Expr &height,
+                       const Halide::Expr &channels);
+
+    Halide::Func
+    average(const Halide::Func &image, const Halide::Type &image_type,
+            const Halide::Expr &width, const Halide::Expr &height,
+            const Halide::Expr &channels);
+
+    Halide::Func
+    sampled(const Halide::Func &image, const Halide::Expr &sample_factor);
+
+    Halide::Func
+    strip_statistics(const Halide::Func &image, const Halide::Type &sum_type,
+                     const Halide::Expr &width, const Halide::Expr &height,
+                     const Halide::Expr &norm);
+
+    Halide::Func
+    illuminant_statistics(const Halide::Func &strip_statistics,
+                          const Halide::Type &sum_type,
+                          const Halide::Expr &width,
+                          const Halide::Expr &height,
+                          const Halide::Expr &norm);
+
+    Halide::Expr histogram_slot(const Halide::Expr &value, int bins);
+
+    Halide::Func
+    strip_histograms(const Halide::Func &binned, int bins,
+                     const Halide::Expr &width, const Halide::Expr &height);
+
+    Halide::Func
+    merge_histograms(const Halide::Func &strip_histograms,
+                     const Halide::Expr &height);
+
+    Halide::Expr fast_log2(const Halide::Expr &x);
+
+    Halide::Expr fast_exp2(const Halide::Expr &x);
+
+    Halide::Expr transfer_pow(const Halide::Expr &x, const Halide::Expr &y,
+                              PhotogAccuracy accuracy);
+
+    Halide::Expr
+    srgb_to_linear(const Halide::Expr &channel, PhotogAccuracy accuracy);
+
+    Halide::Expr
+    linear_to_srgb(const Halide::Expr &channel, PhotogAccuracy accuracy);
+
+    Halide::Expr
+    rgb_to_linear(const Halide::Expr &channel, const Halide::Expr &gamma,
+                  PhotogAccuracy accuracy);
+
+    Halide::Expr
+    linear_to_rgb(const Halide::Expr &channel, const Halide::Expr &gamma,
+                  PhotogAccuracy accuracy);
+
+    Halide::Func
+    rgb_to_xyz(const Halide::Func &rgb, const Halide::Expr &gamma,
+               const Halide::Func &rgb_to_xyz_xfmr, PhotogAccuracy accuracy);
+
+    Halide::Func
+    xyz_to_rgb(const Halide::Func &xyz, const Halide::Expr &gamma,
+               const Halide::Func &xyz_to_rgb_xfmr, PhotogAccuracy accuracy);
+
+    Halide::Func
+    chromadapt(const Halide::Func &rgb, const Halide::Expr &gamma,
+               const Halide::Func &rgb_to_xyz_xfmr,
+               const Halide::Func &xyz_to_rgb_xfmr,
+               const Halide::Func &transform, PhotogAccuracy accuracy);
+
+    Halide::Func
+    chromadapt_folded(const Halide::Func &rgb, const Halide::Expr &gamma,
+                      const Halide::Func &rgb_transform,
+                      PhotogAccuracy accuracy);
+
+    Halide::Func compose_xfmrs(const Halide::Func &a, const Halide::Func &b);
+
+    Halide::Func
+    chromadapt_transform(const Halide::Func &source_tristimulus,
+                         const Halide::Func &dest_tristimulus,
+                         const Halide::Func &xyz_to_lms_xfmr,
+                         const Halide::Func &lms_to_xyz_xfmr);
+
+    Halide::Func
+    gray_world_xfmr(const Halide::Func &source_rgb, const Halide::Expr &gamma,
+                    const Halide::Func &rgb_to_xyz_xfmr,
+                    const Halide::Func &xyz_to_rgb_xfmr,
+                    const Halide::Func &xyz_to_lms_xfmr,
+                    const Halide::Func &lms_to_xyz_xfmr,
+                    const Halide::Func &dest_tristimulus,
+                    PhotogAccuracy accuracy);
+
+    Halide::Func
+    chromadapt_gray_world(const Halide::Func &image, const Halide::Expr &width,
+                          const Halide::Expr &height,
+                          const Halide::Expr &channels,
+                          const Halide::Expr &sample_factor,
+                          const Halide::Expr &gamma,
+                          const Halide::Func &rgb_to_xyz_xfmr,
+                          const Halide::Func &xyz_to_rgb_xfmr,
+                          const Halide::Func &xyz_to_lms_xfmr,
+                          const Halide::Func &lms_to_xyz_xfmr,
+                          const Halide::Func &dest_tristimulus,
+                          PhotogAccuracy accuracy);
+
+    Halide::Func
+    apply_lut(const Halide::Func &rgb, const Halide::Func &lut,
+              const Halide::Expr &size);
+}
+
+#endif // PHOTOG_COLOR_FUNCS_H
@@ -1,88 +1,399 @@
+#include <vector>
+
 #include "Halide.h"
 
 #include "photog/color.h"
+#include "color_funcs.h"
 #include "color_utils.h"
-#include "constants.h"
 #include "generator.h"
 
 namespace photog {
-    /** Calculates average pixel value for an image.*/
-    Halide::Func
-    average(const Halide::Func &image, const Halide::Type &image_type,
-            const Halide::Expr &width, const Halide::Expr &height,
-            const Halide::Expr &channels) {
-        Halide::Func average{"func_average"}, sum{"func_sum"};
-        Halide::Var c{"func_c"};
-        Halide::RDom r{0, width, 0, height};
-        Halide::Type narrow = image_type;
-        Halide::Type wide;
-
-        if (image_type.bits() != 64)
-            wide = image_type.widen();
-        else
-            wide = narrow;
-
-        // Refactoring this code to remove intermediate Func sum does not yield a speed increase.
-        sum(c) = Halide::cast(wide, 0);
-        sum(c) = Halide::sum(Halide::cast(wide, image(r.x, r.y, c)));
-        average(c) = Halide::cast(narrow, sum(c) / (width * height * channels));
-
-        return average;
-    }
-
     class Average : public photog::Generator<Average> {
     public:
-        // TODO: How do we vary type for testing?
-        Input <Buffer<float>> input{"input", 3};
+        Input <Buffer<>> input{"input", 3};
+        Output <Buffer<float>> average{"average", 1};
+
+        Func strip_sum{"strip_sum"};
+        Var c{"c"};
+
+        void generate() {
+            strip_sum = photog::strip_sums(photog::colors(input, alpha),
+                                           photog::accumulator_type(
+                                                   Float(32)),
+                                           input.width(), input.height());
+            average(c) = photog::average_strip_sums(strip_sum, Float(32),
+                                                    input.width(),
+                                                    input.height(), 3)(c);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            average.set_estimates({{0, 3}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+            Var s = strip_sum.args()[0];
+            Var strip_c = strip_sum.args()[1];
+            std::vector<RVar> r = strip_sum.rvars(0);
+
+            // The auto-scheduler runs reductions over a whole image on a
+            // single core. Strips are independent so we sum them in parallel.
+            strip_sum.compute_root()
+                    .parallel(s);
+
+            if (layout == PhotogLayout::Planar) {
+                strip_sum.update()
+                        .reorder(r[0], r[1], strip_c, s)
+                        .parallel(s);
+            } else if (layout == PhotogLayout::Interleaved) {
+                // Visit all channels of a pixel together to read contiguously.
+                strip_sum.update()
+                        .reorder(strip_c, r[0], r[1], s)
+                        .parallel(s);
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+    };
+
+    /** Averages a strided grid of an image's pixels, every sample_factor-th
+     * pixel in each dimension.
+     *
+     * Rows between grid rows are never read, so memory traffic falls with
+     * the sample factor.*/
+    class AverageSampled : public photog::Generator<AverageSampled> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        Input<int> sample_factor{"sample_factor"};
         Output <Buffer<float>> average{"average", 1};
 
+        Func strip_sum{"strip_sum"};
         Var c{"c"};
 
         void generate() {
-            // TODO: Auto-scheduling limits to a single core here. Use atomic to parallelize?
-            average(c) = photog::average(input, input.type(), input.width(),
-                                         input.height(), input.channels())(c);
+            Expr sample_width = (input.width() - 1) / sample_factor + 1;
+            Expr sample_height = (input.height() - 1) / sample_factor + 1;
+
+            strip_sum = photog::strip_sums(
+                    photog::sampled(photog::colors(input, alpha),
+                                    sample_factor),
+                    photog::accumulator_type(Float(32)), sample_width,
+                    sample_height);
+            average(c) = photog::average_strip_sums(strip_sum, Float(32),
+                                                    sample_width,
+                                                    sample_height, 3)(c);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            sample_factor.set_estimate(4);
+
+            average.set_estimates({{0, 3}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+            Var s = strip_sum.args()[0];
+            Var strip_c = strip_sum.args()[1];
+            std::vector<RVar> r = strip_sum.rvars(0);
+
+            // As for Average, strips of grid rows are summed in parallel.
+            strip_sum.compute_root()
+                    .parallel(s);
+
+            if (layout == PhotogLayout::Planar) {
+                strip_sum.update()
+                        .reorder(r[0], r[1], strip_c, s)
+                        .parallel(s);
+            } else if (layout == PhotogLayout::Interleaved) {
+                strip_sum.update()
+                        .reorder(strip_c, r[0], r[1], s)
+                        .parallel(s);
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+    };
+
+    /** Gathers the statistics of every PhotogIlluminantEstimator but
+     * gray-world, whose mean Average reads more cheaply, in a single read of
+     * an image.*/
+    class IlluminantStatistics
+            : public photog::Generator<IlluminantStatistics> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        // Minkowski norm of shades-of-gray and gray-edge estimates.
+        Input<float> norm{"norm"};
+        Output <Buffer<float>> statistics{"statistics", 2};
+
+        Func strip_stats{"strip_stats"};
+        Var c{"c"}, e{"e"};
+
+        void generate() {
+            Type sum_type = photog::accumulator_type(Float(32));
+
+            strip_stats = photog::strip_statistics(
+                    photog::colors(input, alpha), sum_type, input.width(),
+                    input.height(), norm);
+            statistics(c, e) = photog::illuminant_statistics(
+                    strip_stats, sum_type, input.width(), input.height(),
+                    norm)(c, e);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()}, E{3};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            norm.set_estimate(6.0f);
+
+            statistics.set_estimates({{0, 3},
+                                      {0, E}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+            Var s = strip_stats.args()[0];
+            Var strip_c = strip_stats.args()[1];
+            std::vector<RVar> r = strip_stats.rvars(0);
+
+            // As for Average, strips are reduced in parallel.
+            strip_stats.compute_root()
+                    .parallel(s);
+
+            if (layout == PhotogLayout::Planar) {
+                strip_stats.update()
+                        .reorder(r[0], r[1], strip_c, s)
+                        .parallel(s);
+            } else if (layout == PhotogLayout::Interleaved) {
+                strip_stats.update()
+                        .reorder(strip_c, r[0], r[1], s)
+                        .parallel(s);
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
+    };
+
+    /** Fills a histogram of each color channel of an image, with the count,
+     * minimum and maximum of the values in each slot (see
+     * photog::histogram_slot), in a single read of the image.*/
+    class Histogram : public photog::Generator<Histogram> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        Output <Buffer<uint32_t>> counts{"counts", 2};
+        Output <Buffer<float>> minimums{"minimums", 2};
+        Output <Buffer<float>> maximums{"maximums", 2};
+
+        Func binned{"binned"}, strip_histogram{"strip_histogram"},
+                histogram{"histogram"};
+        Var x{"x"}, y{"y"}, b{"b"}, c{"c"};
+
+        void generate() {
+            const int B{PHOTOG_HISTOGRAM_BINS};
+            Func normalized = photog::colors(input, alpha);
+
+            binned(x, y, c) = {photog::histogram_slot(normalized(x, y, c), B),
+                               normalized(x, y, c)};
+            strip_histogram = photog::strip_histograms(binned, B,
+                                                       input.width(),
+                                                       input.height());
+            histogram = photog::merge_histograms(strip_histogram,
+                                                 input.height());
+            counts(b, c) = histogram(b, c)[0];
+            minimums(b, c) = histogram(b, c)[1];
+            maximums(b, c) = histogram(b, c)[2];
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()}, B{PHOTOG_HISTOGRAM_BINS + 2};
 
             input.set_estimates({{0, X},
                                  {0, Y},
                                  {0, C}});
 
-            average.set_estimates({{0, C}});
+            counts.set_estimates({{0, B},
+                                  {0, 3}});
+            minimums.set_estimates({{0, B},
+                                    {0, 3}});
+            maximums.set_estimates({{0, B},
+                                    {0, 3}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+            }
+        }
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+        void schedule_manual() override {
+            const int C{image_channels()};
+            const int vector_size{natural_vector_size(Float(32))};
+            Var s = strip_histogram.args()[1];
+            Var strip_c = strip_histogram.args()[2];
+            std::vector<RVar> r = strip_histogram.rvars(0);
+
+            // Strips fill their histograms in parallel. Slots are scattered
+            // one element at a time, but each row is normalized and binned
+            // with vectors first.
+            strip_histogram.compute_root()
+                    .parallel(s);
+            binned.compute_at(strip_histogram, r[1])
+                    .vectorize(x, vector_size);
+
+            if (layout == PhotogLayout::Planar) {
+                strip_histogram.update()
+                        .reorder(r[0], r[1], strip_c, s)
+                        .parallel(s);
+            } else if (layout == PhotogLayout::Interleaved) {
+                binned.reorder(c, x)
+                        .bound(c, 0, 3)
+                        .unroll(c);
+                strip_histogram.update()
+                        .reorder(strip_c, r[0], r[1], s)
+                        .parallel(s);
                 input.dim(0).set_stride(C);
                 input.dim(2).set_stride(1);
             }
+
+            // Histograms are merged once, and shared by every output.
+            Var slot = histogram.args()[0], hist_c = histogram.args()[1];
+            RVar strip = histogram.rvars(0)[0];
+            histogram.compute_root()
+                    .update()
+                    .reorder(slot, hist_c, strip)
+                    .vectorize(slot, vector_size);
         }
     };
 
-    Halide::Expr srgb_to_linear(const Halide::Expr &channel) {
-        return Halide::select(channel <= 0.04045f,
-                              channel / 12.92f,
-                              Halide::pow((channel + 0.055f) / 1.055f,
-                                          2.4f));
-    }
+    /** Applies a 3D lookup table baked from a color transform with
+     * tetrahedral interpolation.
+     *
+     * The table holds (r, g, b, c) samples on a grid of equal size in each
+     * dimension, e.g. 33x33x33x3.*/
+    class ApplyLut : public photog::Generator<ApplyLut> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        Input <Buffer<float>> lut{"lut", 4};
+        Output <Buffer<>> output{"output", 3};
+
+        Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
+
+        void generate() {
+            Func looked_up{"looked_up"};
+
+            normalized = photog::colors(input, alpha);
+            looked_up(x, y, c) = photog::apply_lut(normalized, lut,
+                                                   lut.dim(0).extent())(x, y,
+                                                                        c);
+            output(x, y, c) =
+                    photog::with_alpha(looked_up, input, output.type(),
+                                       alpha)(x, y, c);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()}, size{33};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            lut.set_estimates({{0, size},
+                               {0, size},
+                               {0, size},
+                               {0, 3}});
+
+            output.set_estimates({{0, X},
+                                  {0, Y},
+                                  {0, C}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+                output.dim(0).set_stride(C);
+                output.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            // Every channel of a vector of pixels is looked up together, so
+            // the table's corners are gathered with vector loads. Reading
+            // each pixel before writing it also lets input and output be
+            // the same image.
+            schedule_in_place(output, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+                output.dim(0).set_stride(C);
+                output.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class SrgbToLinear : public photog::Generator<SrgbToLinear> {
     public:
-        // TODO: Can we avoid explicit typing here?
-        // TODO: How do we handle 4-channel images?
-        Input <Buffer<float>> srgb{"srgb", 3};
-        Output <Buffer<float>> linear{"linear", 3};
+        Input <Buffer<>> srgb{"srgb", 3};
+        Output <Buffer<>> linear{"linear", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
 
         void generate() {
-            linear(x, y, c) = photog::srgb_to_linear(srgb(x, y, c));
+            Func converted{"converted"};
+
+            normalized = photog::colors(srgb, alpha);
+            converted(x, y, c) = photog::srgb_to_linear(normalized(x, y, c),
+                                                        accuracy);
+            linear(x, y, c) =
+                    photog::with_alpha(converted, srgb, linear.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             srgb.set_estimates({{0, X},
                                 {0, Y},
@@ -92,36 +403,52 @@ namespace photog {
                                   {0, Y},
                                   {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 srgb.dim(0).set_stride(C);
                 srgb.dim(2).set_stride(1);
                 linear.dim(0).set_stride(C);
                 linear.dim(2).set_stride(1);
             }
         }
-    };
 
-    Halide::Expr linear_to_srgb(const Halide::Expr &channel) {
-        return Halide::select(channel <= 0.0031308f,
-                              channel * 12.92f,
-                              (1.055f * Halide::pow(channel,
-                                                    1 / 2.4f)) - 0.055f);
-    }
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(linear, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                srgb.dim(0).set_stride(C);
+                srgb.dim(2).set_stride(1);
+                linear.dim(0).set_stride(C);
+                linear.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class LinearToSrgb : public photog::Generator<LinearToSrgb> {
     public:
-        Input <Buffer<float>> linear{"linear", 3};
-        Output <Buffer<float>> srgb{"srgb", 3};
+        Input <Buffer<>> linear{"linear", 3};
+        Output <Buffer<>> srgb{"srgb", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
 
         void generate() {
-            srgb(x, y, c) = photog::linear_to_srgb(linear(x, y, c));
+            Func converted{"converted"};
+
+            normalized = photog::colors(linear, alpha);
+            converted(x, y, c) = photog::linear_to_srgb(normalized(x, y, c),
+                                                        accuracy);
+            srgb(x, y, c) =
+                    photog::with_alpha(converted, linear, srgb.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             linear.set_estimates({{0, X},
                                   {0, Y},
@@ -131,35 +458,54 @@ namespace photog {
                                 {0, Y},
                                 {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 linear.dim(0).set_stride(C);
                 linear.dim(2).set_stride(1);
                 srgb.dim(0).set_stride(C);
                 srgb.dim(2).set_stride(1);
             }
         }
-    };
 
-    Halide::Expr
-    rgb_to_linear(const Halide::Expr &channel, const Halide::Expr &gamma) {
-        return Halide::pow(channel, gamma);
-    }
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(srgb, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                linear.dim(0).set_stride(C);
+                linear.dim(2).set_stride(1);
+                srgb.dim(0).set_stride(C);
+                srgb.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class RgbToLinear : public photog::Generator<RgbToLinear> {
     public:
-        Input <Buffer<float>> rgb{"rgb", 3};
+        Input <Buffer<>> rgb{"rgb", 3};
         Input<float> gamma{"gamma"};
-        Output <Buffer<float>> linear{"linear", 3};
+        Output <Buffer<>> linear{"linear", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
 
         void generate() {
-            linear(x, y, c) = photog::rgb_to_linear(rgb(x, y, c), gamma);
+            Func converted{"converted"};
+
+            normalized = photog::colors(rgb, alpha);
+            converted(x, y, c) =
+                    photog::rgb_to_linear(normalized(x, y, c), gamma,
+                                                accuracy);
+            linear(x, y, c) =
+                    photog::with_alpha(converted, rgb, linear.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             rgb.set_estimates({{0, X},
                                {0, Y},
@@ -171,35 +517,54 @@ namespace photog {
                                   {0, Y},
                                   {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 rgb.dim(0).set_stride(C);
                 rgb.dim(2).set_stride(1);
                 linear.dim(0).set_stride(C);
                 linear.dim(2).set_stride(1);
             }
         }
-    };
 
-    Halide::Expr
-    linear_to_rgb(const Halide::Expr &channel, const Halide::Expr &gamma) {
-        return Halide::pow(channel, 1 / gamma);
-    }
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(linear, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                rgb.dim(0).set_stride(C);
+                rgb.dim(2).set_stride(1);
+                linear.dim(0).set_stride(C);
+                linear.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class LinearToRgb : public photog::Generator<LinearToRgb> {
     public:
-        Input <Buffer<float>> linear{"linear", 3};
+        Input <Buffer<>> linear{"linear", 3};
         Input<float> gamma{"gamma"};
-        Output <Buffer<float>> rgb{"rgb", 3};
+        Output <Buffer<>> rgb{"rgb", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
 
         void generate() {
-            rgb(x, y, c) = photog::linear_to_rgb(linear(x, y, c), gamma);
+            Func converted{"converted"};
+
+            normalized = photog::colors(linear, alpha);
+            converted(x, y, c) =
+                    photog::linear_to_rgb(normalized(x, y, c), gamma,
+                                                accuracy);
+            rgb(x, y, c) =
+                    photog::with_alpha(converted, linear, rgb.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             linear.set_estimates({{0, X},
                                   {0, Y},
@@ -211,8 +576,22 @@ namespace photog {
                                {0, Y},
                                {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                linear.dim(0).set_stride(C);
+                linear.dim(2).set_stride(1);
+                rgb.dim(0).set_stride(C);
+                rgb.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(rgb, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 linear.dim(0).set_stride(C);
                 linear.dim(2).set_stride(1);
                 rgb.dim(0).set_stride(C);
@@ -223,8 +602,8 @@ namespace photog {
 
     class SrgbToXyz : public photog::Generator<SrgbToXyz> {
     public:
-        Input <Buffer<float>> srgb{"srgb", 3};
-        Output <Buffer<float>> xyz{"xyz", 3};
+        Input <Buffer<>> srgb{"srgb", 3};
+        Output <Buffer<>> xyz{"xyz", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
         Func linear{"linear"};
@@ -232,14 +611,23 @@ namespace photog {
         void generate() {
             Halide::Buffer<float> rgb_to_xyz_xfmr =
                     photog::get_rgb_to_xyz_xfmr(PhotogWorkingSpace::Srgb);
-            linear(x, y, c) = photog::srgb_to_linear(srgb(x, y, c));
-            xyz(x, y, c) = rgb_to_xyz_xfmr(0, c) * linear(x, y, 0) +
-                           rgb_to_xyz_xfmr(1, c) * linear(x, y, 1) +
-                           rgb_to_xyz_xfmr(2, c) * linear(x, y, 2);
+            Func converted{"converted"};
+
+            linear(x, y, c) =
+                    photog::srgb_to_linear(
+                            photog::colors(srgb, alpha)(x, y, c), accuracy);
+            converted(x, y, c) = photog::xyz_scale(xyz.type()) *
+                                 (rgb_to_xyz_xfmr(0, c) * linear(x, y, 0) +
+                                  rgb_to_xyz_xfmr(1, c) * linear(x, y, 1) +
+                                  rgb_to_xyz_xfmr(2, c) * linear(x, y, 2));
+            xyz(x, y, c) =
+                    photog::with_alpha(converted, srgb, xyz.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             srgb.set_estimates({{0, X},
                                 {0, Y},
@@ -249,46 +637,58 @@ namespace photog {
                                {0, Y},
                                {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 srgb.dim(0).set_stride(C);
                 srgb.dim(2).set_stride(1);
                 xyz.dim(0).set_stride(C);
                 xyz.dim(2).set_stride(1);
             }
         }
-    };
 
-    Halide::Func
-    rgb_to_xyz(const Halide::Func &rgb, const Halide::Expr &gamma,
-               const Halide::Func &rgb_to_xyz_xfmr) {
-        Halide::Func linear{"linear"}, xyz{"xyz"};
-        Halide::Var x{"x"}, y{"y"}, c{"c"};
+        void schedule_manual() override {
+            const int C{image_channels()};
 
-        linear(x, y, c) = photog::rgb_to_linear(rgb(x, y, c), gamma);
-        xyz(x, y, c) = rgb_to_xyz_xfmr(0, c) * linear(x, y, 0) +
-                       rgb_to_xyz_xfmr(1, c) * linear(x, y, 1) +
-                       rgb_to_xyz_xfmr(2, c) * linear(x, y, 2);
+            schedule_in_place(xyz, linear);
 
-        return xyz;
-    }
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                srgb.dim(0).set_stride(C);
+                srgb.dim(2).set_stride(1);
+                xyz.dim(0).set_stride(C);
+                xyz.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class RgbToXyz : public photog::Generator<RgbToXyz> {
     public:
-        Input <Buffer<float>> rgb{"rgb", 3};
+        Input <Buffer<>> rgb{"rgb", 3};
         Input<float> gamma{"gamma"};
-        Input <Buffer<float>> rgb_to_xyz_xfmr{"xyz_to_rgb_xfmr", 2};
-        Output <Buffer<float>> xyz{"xyz", 3};
+        Input <Buffer<float>> rgb_to_xyz_xfmr{"rgb_to_xyz_xfmr", 2};
+        Output <Buffer<>> xyz{"xyz", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func linear{"linear"};
 
         void generate() {
+            Func converted{"converted"};
+
+            linear(x, y, c) =
+                    photog::rgb_to_linear(photog::colors(rgb, alpha)(x, y, c),
+                                          gamma, accuracy);
+            converted(x, y, c) = photog::xyz_scale(xyz.type()) *
+                                 (rgb_to_xyz_xfmr(0, c) * linear(x, y, 0) +
+                                  rgb_to_xyz_xfmr(1, c) * linear(x, y, 1) +
+                                  rgb_to_xyz_xfmr(2, c) * linear(x, y, 2));
             xyz(x, y, c) =
-                    photog::rgb_to_xyz(rgb, gamma, rgb_to_xyz_xfmr)(x, y, c);
+                    photog::with_alpha(converted, rgb, xyz.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             rgb.set_estimates({{0, X},
                                {0, Y},
@@ -300,8 +700,22 @@ namespace photog {
                                {0, Y},
                                {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                rgb.dim(0).set_stride(C);
+                rgb.dim(2).set_stride(1);
+                xyz.dim(0).set_stride(C);
+                xyz.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(xyz, linear);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 rgb.dim(0).set_stride(C);
                 rgb.dim(2).set_stride(1);
                 xyz.dim(0).set_stride(C);
@@ -312,23 +726,32 @@ namespace photog {
 
     class XyzToSrgb : public photog::Generator<XyzToSrgb> {
     public:
-        Input <Buffer<float>> xyz{"xyz", 3};
-        Output <Buffer<float>> srgb{"srgb", 3};
+        Input <Buffer<>> xyz{"xyz", 3};
+        Output <Buffer<>> srgb{"srgb", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
-        Func linear{"linear"};
+        Func linear{"linear"}, normalized{"normalized"};
 
         void generate() {
             Halide::Buffer<float> xyz_to_rgb_xfmr =
                     photog::get_xyz_to_rgb_xfmr(PhotogWorkingSpace::Srgb);
-            linear(x, y, c) = xyz_to_rgb_xfmr(0, c) * xyz(x, y, 0) +
-                              xyz_to_rgb_xfmr(1, c) * xyz(x, y, 1) +
-                              xyz_to_rgb_xfmr(2, c) * xyz(x, y, 2);
-            srgb(x, y, c) = photog::linear_to_srgb(linear(x, y, c));
+            Func converted{"converted"};
+
+            normalized(x, y, c) = photog::colors(xyz, alpha)(x, y, c) /
+                                  photog::xyz_scale(xyz.type());
+            linear(x, y, c) = xyz_to_rgb_xfmr(0, c) * normalized(x, y, 0) +
+                              xyz_to_rgb_xfmr(1, c) * normalized(x, y, 1) +
+                              xyz_to_rgb_xfmr(2, c) * normalized(x, y, 2);
+            converted(x, y, c) = photog::linear_to_srgb(linear(x, y, c),
+                                                        accuracy);
+            srgb(x, y, c) =
+                    photog::with_alpha(converted, xyz, srgb.type(),
+                                       alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             xyz.set_estimates({{0, X},
                                {0, Y},
@@ -338,48 +761,53 @@ namespace photog {
                                 {0, Y},
                                 {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 xyz.dim(0).set_stride(C);
                 xyz.dim(2).set_stride(1);
                 srgb.dim(0).set_stride(C);
                 srgb.dim(2).set_stride(1);
             }
         }
-    };
-
-    Halide::Func
-    xyz_to_rgb(const Halide::Func &xyz, const Halide::Expr &gamma,
-               const Halide::Func &xyz_to_rgb_xfmr) {
-        Halide::Func linear{"linear"}, rgb{"rgb"};
-        Halide::Var x{"x"}, y{"y"}, c{"c"};
 
-        linear(x, y, c) = xyz_to_rgb_xfmr(0, c) * xyz(x, y, 0) +
-                          xyz_to_rgb_xfmr(1, c) * xyz(x, y, 1) +
-                          xyz_to_rgb_xfmr(2, c) * xyz(x, y, 2);
+        void schedule_manual() override {
+            const int C{image_channels()};
 
-        rgb(x, y, c) = Halide::clamp(linear_to_rgb(linear(x, y, c), gamma),
-                                     0.0f, 1.0f);
+            schedule_in_place(srgb, normalized);
 
-        return rgb;
-    }
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                xyz.dim(0).set_stride(C);
+                xyz.dim(2).set_stride(1);
+                srgb.dim(0).set_stride(C);
+                srgb.dim(2).set_stride(1);
+            }
+        }
+    };
 
     class XyzToRgb : public photog::Generator<XyzToRgb> {
     public:
-        Input <Buffer<float>> xyz{"xyz", 3};
+        Input <Buffer<>> xyz{"xyz", 3};
         Input<float> gamma{"gamma"};
         Input <Buffer<float>> xyz_to_rgb_xfmr{"xyz_to_rgb_xfmr", 2};
-        Output <Buffer<float>> rgb{"rgb", 3};
+        Output <Buffer<>> rgb{"rgb", 3};
 
         Var x{"x"}, y{"y"}, c{"c"};
+        Func normalized{"normalized"};
 
         void generate() {
+            normalized(x, y, c) = photog::colors(xyz, alpha)(x, y, c) /
+                                  photog::xyz_scale(xyz.type());
             rgb(x, y, c) =
-                    photog::xyz_to_rgb(xyz, gamma, xyz_to_rgb_xfmr)(x, y, c);
+                    photog::with_alpha(
+                            photog::xyz_to_rgb(normalized, gamma,
+                                               xyz_to_rgb_xfmr, accuracy),
+                            xyz, rgb.type(), alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             xyz.set_estimates({{0, X},
                                {0, Y},
@@ -391,8 +819,22 @@ namespace photog {
                                {0, Y},
                                {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                xyz.dim(0).set_stride(C);
+                xyz.dim(2).set_stride(1);
+                rgb.dim(0).set_stride(C);
+                rgb.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+
+            schedule_in_place(rgb, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
                 xyz.dim(0).set_stride(C);
                 xyz.dim(2).set_stride(1);
                 rgb.dim(0).set_stride(C);
@@ -410,25 +852,60 @@ namespace photog {
         Input <Buffer<float>> transform{"transform", 2};
         Output <Buffer<float>> output{"output", 3};
 
-        Func adapted{"adapted"}, xyz{"xyz"};
         Var x{"x"}, y{"y"}, c{"c"};
 
         void generate() {
-            xyz(x, y, c) =
-                    photog::rgb_to_xyz(input, gamma, rgb_to_xyz_xfmr)(x, y, c);
+            output(x, y, c) =
+                    photog::chromadapt(input, gamma, rgb_to_xyz_xfmr,
+                                       xyz_to_rgb_xfmr, transform,
+                                       accuracy)(x, y, c);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            gamma.set_estimate(2.2);
+
+            output.set_estimates({{0, X},
+                                  {0, Y},
+                                  {0, C}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+                output.dim(0).set_stride(C);
+                output.dim(2).set_stride(1);
+            }
+        }
+    };
 
-            adapted(x, y, c) =
-                    transform(0, c) * xyz(x, y, 0) +
-                    transform(1, c) * xyz(x, y, 1) +
-                    transform(2, c) * xyz(x, y, 2);
+    class ChromadaptFolded : public photog::Generator<ChromadaptFolded> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        Input<float> gamma{"gamma"};
+        Input <Buffer<float>> rgb_transform{"rgb_transform", 2};
+        Output <Buffer<>> output{"output", 3};
 
+        Var x{"x"}, y{"y"}, c{"c"};
+
+        void generate() {
             output(x, y, c) =
-                    photog::xyz_to_rgb(adapted, gamma,
-                                       xyz_to_rgb_xfmr)(x, y, c);
+                    photog::with_alpha(
+                            photog::chromadapt_folded(
+                                    photog::colors(input, alpha), gamma,
+                                    rgb_transform, accuracy),
+                            input, output.type(), alpha)(x, y, c);
         }
 
         void schedule_auto() override {
-            const int X{x_extent_estimate}, Y{y_extent_estimate}, C{3};
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
 
             input.set_estimates({{0, X},
                                  {0, Y},
@@ -440,8 +917,119 @@ namespace photog {
                                   {0, Y},
                                   {0, C}});
 
-            if (layout == Layout::Planar) {
-            } else if (layout == Layout::Interleaved) {
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+                output.dim(0).set_stride(C);
+                output.dim(2).set_stride(1);
+            }
+        }
+    };
+
+    /** Estimates the source illuminant of an image with the gray-world method
+     * and chromatically adapts the image to a destination illuminant in a
+     * single pipeline.
+     *
+     * The estimate is taken from every sample_factor-th pixel in each
+     * dimension so that the estimation pass reads a fraction of the image.
+     * The transform is computed in-pipeline which avoids a host round trip
+     * between estimation and adaptation.*/
+    class ChromadaptFused : public photog::Generator<ChromadaptFused> {
+    public:
+        Input <Buffer<>> input{"input", 3};
+        Input<int> sample_factor{"sample_factor"};
+        Input<float> gamma{"gamma"};
+        Input <Buffer<float>> rgb_to_xyz_xfmr{"rgb_to_xyz_xfmr", 2};
+        Input <Buffer<float>> xyz_to_rgb_xfmr{"xyz_to_rgb_xfmr", 2};
+        Input <Buffer<float>> xyz_to_lms_xfmr{"xyz_to_lms_xfmr", 2};
+        Input <Buffer<float>> lms_to_xyz_xfmr{"lms_to_xyz_xfmr", 2};
+        Input <Buffer<float>> dest_tristimulus{"dest_tristimulus", 1};
+        Output <Buffer<>> output{"output", 3};
+
+        Func strip_sum{"strip_sum"}, source_rgb{"source_rgb"},
+                rgb_transform{"rgb_transform"}, normalized{"normalized"};
+        Var x{"x"}, y{"y"}, c{"c"};
+
+        void generate() {
+            Expr sample_width = (input.width() - 1) / sample_factor + 1;
+            Expr sample_height = (input.height() - 1) / sample_factor + 1;
+
+            // Colors are estimated from and adapted without alpha. The
+            // estimate reads its own copy of the colors, as it is computed
+            // before any pixel is adapted.
+            strip_sum = photog::strip_sums(
+                    photog::sampled(photog::colors(input, alpha),
+                                    sample_factor),
+                    photog::accumulator_type(Float(32)), sample_width,
+                    sample_height);
+            source_rgb(c) = photog::average_strip_sums(strip_sum, Float(32),
+                                                       sample_width,
+                                                       sample_height, 3)(c);
+            rgb_transform = photog::gray_world_xfmr(
+                    source_rgb, gamma, rgb_to_xyz_xfmr, xyz_to_rgb_xfmr,
+                    xyz_to_lms_xfmr, lms_to_xyz_xfmr, dest_tristimulus,
+                    accuracy);
+
+            normalized = photog::colors(input, alpha);
+            output(x, y, c) =
+                    photog::with_alpha(
+                            photog::chromadapt_folded(normalized, gamma,
+                                                      rgb_transform,
+                                                      accuracy),
+                            input, output.type(), alpha)(x, y, c);
+        }
+
+        void schedule_auto() override {
+            const int X{x_extent_estimate}, Y{y_extent_estimate},
+                    C{image_channels()};
+
+            input.set_estimates({{0, X},
+                                 {0, Y},
+                                 {0, C}});
+
+            sample_factor.set_estimate(4);
+
+            gamma.set_estimate(2.2);
+
+            output.set_estimates({{0, X},
+                                  {0, Y},
+                                  {0, C}});
+
+            if (layout == PhotogLayout::Planar) {
+            } else if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(C);
+                input.dim(2).set_stride(1);
+                output.dim(0).set_stride(C);
+                output.dim(2).set_stride(1);
+            }
+        }
+
+        void schedule_manual() override {
+            const int C{image_channels()};
+            Var s = strip_sum.args()[0];
+            Var strip_c = strip_sum.args()[1];
+            std::vector<RVar> r = strip_sum.rvars(0);
+
+            // As for AverageSampled, strips of grid rows are summed in
+            // parallel.
+            strip_sum.compute_root()
+                    .parallel(s);
+
+            // The estimate and transform are computed once per call.
+            source_rgb.compute_root();
+            rgb_transform.compute_root();
+
+            schedule_in_place(output, normalized);
+
+            if (layout == PhotogLayout::Planar) {
+                strip_sum.update()
+                        .reorder(r[0], r[1], strip_c, s)
+                        .parallel(s);
+            } else if (layout == PhotogLayout::Interleaved) {
+                strip_sum.update()
+                        .reorder(strip_c, r[0], r[1], s)
+                        .parallel(s);
                 input.dim(0).set_stride(C);
                 input.dim(2).set_stride(1);
                 output.dim(0).set_stride(C);
@@ -461,4 +1049,10 @@ HALIDE_REGISTER_GENERATOR(photog::LinearToRgb, photog_linear_to_rgb);
 HALIDE_REGISTER_GENERATOR(photog::XyzToSrgb, photog_xyz_to_srgb);
 HALIDE_REGISTER_GENERATOR(photog::XyzToRgb, photog_xyz_to_rgb);
 HALIDE_REGISTER_GENERATOR(photog::Average, photog_average);
+HALIDE_REGISTER_GENERATOR(photog::AverageSampled, photog_average_sampled);
+HALIDE_REGISTER_GENERATOR(photog::IlluminantStatistics, photog_illuminant_statistics);
+HALIDE_REGISTER_GENERATOR(photog::Histogram, photog_histogram);
+HALIDE_REGISTER_GENERATOR(photog::ApplyLut, photog_apply_lut);
 HALIDE_REGISTER_GENERATOR(photog::Chromadapt, photog_chromadapt_impl);
+HALIDE_REGISTER_GENERATOR(photog::ChromadaptFolded, photog_chromadapt_folded_impl);
+HALIDE_REGISTER_GENERATOR(photog::ChromadaptFused, photog_chromadapt_fused_impl);
@@ -0,0 +1,72 @@
+#ifndef PHOTOG_COLOR_LIBRARIES_H
+#define PHOTOG_COLOR_LIBRARIES_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "Halide.h"
+
+#include "photog/color.h"
+
+namespace photog {
+    /** Image sizes that libraries are auto-scheduled for.*/
+    enum SizeBucket {
+        Small, Medium, Huge
+    };
+
+    /** Picks the size bucket whose estimated pixel count is nearest to an
+     * image's, comparing on a logarithmic scale.
+     *
+     * Estimates are preprocessor-defines set in the build system.*/
+    inline SizeBucket get_size_bucket(int width, int height) {
+        double pixels = static_cast<double>(width) * height;
+        double small = static_cast<double>(SMALL_X_EXTENT_ESTIMATE) *
+                       SMALL_Y_EXTENT_ESTIMATE;
+        double medium = static_cast<double>(X_EXTENT_ESTIMATE) *
+                        Y_EXTENT_ESTIMATE;
+        double huge = static_cast<double>(HUGE_X_EXTENT_ESTIMATE) *
+                      HUGE_Y_EXTENT_ESTIMATE;
+
+        if (pixels < std::sqrt(small * medium))
+            return SizeBucket::Small;
+        else if (pixels < std::sqrt(medium * huge))
+            return SizeBucket::Medium;
+        else
+            return SizeBucket::Huge;
+    }
+
+    /** Returns a variant chosen from a dispatch table, aborting if the build
+     * generates none for the image.*/
+    template<typename Library>
+    Library get_variant(Library variant, const char *library) {
+        if (!variant) {
+            std::cerr << "Unsupported element type, layout or alpha channel "
+                      << "for " << library << " in photog::get_variant()."
+                      << std::endl;
+            abort();
+        }
+
+        return variant;
+    }
+
+    /** Generated Halide libraries for images with elements of type T.
+     *
+     * Specializations hold a method per library dispatched to by photog's
+     * public functions, named after the library without its photog_ prefix.
+     * Variants of a library share a signature, so they can be chosen at
+     * runtime and called through the same function pointer. Multi-variant
+     * tables are indexed by PhotogAlpha, PhotogLayout, SizeBucket (for
+     * size-bucketed libraries) and then PhotogAccuracy. Only float images
+     * without alpha have size-bucketed variants, and images with alpha use
+     * exact variants at every accuracy.*/
+    template<typename T>
+    struct ColorLibraries;
+}
+
+// Available after a CMake build. Specializes ColorLibraries for each element
+// type from the variants that the build generates.
+#include "color_library_tables.h"
+
+#endif // PHOTOG_COLOR_LIBRARIES_H
@@ -127,4 +127,35 @@ namespace photog {
 
         return transform;
     }
+
+    /** Folds the chromatic adaptation transform between the working space's
+     * RGB/XYZ transforms. The result adapts linear RGB values directly.*/
+    Halide::Runtime::Buffer<float>
+    create_rgb_transform(PhotogWorkingSpace working_space,
+                         PhotogChromadaptMethod chromadapt_method,
+                         const Halide::Runtime::Buffer<float> &source_tristimulus,
+                         const Halide::Runtime::Buffer<float> &dest_tristimulus) {
+        auto transform =
+                photog::create_transform(chromadapt_method, source_tristimulus,
+                                         dest_tristimulus);
+        auto xyz_transform =
+                photog::mul_33_by_33(transform,
+                                     photog::get_rgb_to_xyz_xfmr(working_space));
+
+        return photog::mul_33_by_33(photog::get_xyz_to_rgb_xfmr(working_space),
+                                    xyz_transform);
+    }
+
+    ChromadaptConstants
+    get_chromadapt_constants(PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant) {
+        return {photog::get_gamma(working_space),
+                photog::get_rgb_to_xyz_xfmr(working_space),
+                photog::get_xyz_to_rgb_xfmr(working_space),
+                photog::get_xyz_to_lms_xfmr(chromadapt_method),
+                photog::get_lms_to_xyz_xfmr(chromadapt_method),
+                photog::copy_to_buffer(
+                        photog::get_tristimulus(dest_illuminant))};
+    }
 }
\ No newline at end of file
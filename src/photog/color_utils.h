@@ -15,6 +15,29 @@ namespace photog {
                      const Halide::Runtime::Buffer<float> &source_tristimulus,
                      const Halide::Runtime::Buffer<float> &dest_tristimulus);
 
+    Halide::Runtime::Buffer<float>
+    create_rgb_transform(PhotogWorkingSpace working_space,
+                         PhotogChromadaptMethod chromadapt_method,
+                         const Halide::Runtime::Buffer<float> &source_tristimulus,
+                         const Halide::Runtime::Buffer<float> &dest_tristimulus);
+
+    /** Per-call constants of photog_chromadapt_fused_impl. They depend only
+     * on the working space, method and destination illuminant, so they can
+     * be shared between images.*/
+    struct ChromadaptConstants {
+        float gamma;
+        Halide::Runtime::Buffer<float> rgb_to_xyz_xfmr;
+        Halide::Runtime::Buffer<float> xyz_to_rgb_xfmr;
+        Halide::Runtime::Buffer<float> xyz_to_lms_xfmr;
+        Halide::Runtime::Buffer<float> lms_to_xyz_xfmr;
+        Halide::Runtime::Buffer<float> dest_tristimulus;
+    };
+
+    ChromadaptConstants
+    get_chromadapt_constants(PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant);
+
     float get_gamma(PhotogWorkingSpace working_space);
 
     std::array<float, 3>
@@ -26,6 +49,12 @@ namespace photog {
     Halide::Runtime::Buffer<float>
     get_xyz_to_rgb_xfmr(PhotogWorkingSpace working_space);
 
+    Halide::Runtime::Buffer<float>
+    get_xyz_to_lms_xfmr(PhotogChromadaptMethod chromadapt_method);
+
+    Halide::Runtime::Buffer<float>
+    get_lms_to_xyz_xfmr(PhotogChromadaptMethod chromadapt_method);
+
     template<typename T>
     Halide::Runtime::Buffer<T>
     rgb_to_xyz(const Halide::Runtime::Buffer<T> &rgb, float gamma,
@@ -1,10 +0,0 @@
-#ifndef PHOTOG_CONSTANTS_H
-#define PHOTOG_CONSTANTS_H
-
-namespace photog {
-    enum class Layout {
-        Planar, Interleaved
-    };
-}
-
-#endif // PHOTOG_CONSTANTS_H
@@ -5,18 +5,37 @@
 
 #include "Halide.h"
 
-#include "constants.h"
+#include "photog/color.h"
 
 namespace photog {
     template<class T>
     class Generator : public Halide::Generator<T> {
     protected:
-        Halide::GeneratorParam<Layout> layout{"layout", Layout::Planar,
-                                              {{"planar",
-                                                Layout::Planar},
-                                               {"interleaved",
-                                                Layout::Interleaved}}};
+        Halide::GeneratorParam<PhotogLayout> layout{"layout",
+                                                    PhotogLayout::Planar,
+                                                    {{"planar",
+                                                      PhotogLayout::Planar},
+                                                     {"interleaved",
+                                                      PhotogLayout::Interleaved}}};
+        // Alpha channel carried from input to output after the color
+        // channels. Images with alpha have 4 channels.
+        Halide::GeneratorParam<PhotogAlpha> alpha{"alpha",
+                                                  PhotogAlpha::Opaque,
+                                                  {{"opaque",
+                                                    PhotogAlpha::Opaque},
+                                                   {"straight",
+                                                    PhotogAlpha::Straight},
+                                                   {"premultiplied",
+                                                    PhotogAlpha::Premultiplied}}};
         Halide::GeneratorParam<bool> manual_schedule{"manual_schedule", false};
+        // Accuracy of transfer functions. Fast approximates powers with
+        // polynomials that vectorize cleanly.
+        Halide::GeneratorParam<PhotogAccuracy> accuracy{"accuracy",
+                                                        PhotogAccuracy::Exact,
+                                                        {{"exact",
+                                                          PhotogAccuracy::Exact},
+                                                         {"fast",
+                                                          PhotogAccuracy::Fast}}};
         // Externally-controlled auto-scheduling estimate variables.
         // Defaults are preprocessor-defines set in the build system.
         // Use in your auto-schedule to set estimated extents for x and y vars.
@@ -57,6 +76,48 @@ namespace photog {
                     << std::endl;
             abort();
         }
+
+    protected:
+        /** Channel count of input and output images, including alpha.*/
+        int image_channels() const {
+            return alpha == PhotogAlpha::Opaque ? 3 : 4;
+        }
+
+        /** Schedules a per-pixel output so that it may overwrite its input.
+         *
+         * pixel reads the input and is computed over all channels of each
+         * vector of output pixels before any of them are stored. Alpha is
+         * stored with the colors of its pixel. Loop tails
+         * are guarded instead of shifted inwards, as recomputing a pixel
+         * would read a value that has already been overwritten.*/
+        void schedule_in_place(Halide::Func output, Halide::Func pixel) {
+            const int C{image_channels()}, rows_per_task{8};
+            const int vector_size{
+                    this->natural_vector_size(Halide::Float(32))};
+            Halide::Var x{output.args()[0]}, y{output.args()[1]},
+                    c{output.args()[2]};
+            Halide::Var xi{"xi"}, yi{"yi"};
+
+            output.bound(c, 0, C)
+                    .split(x, x, xi, vector_size,
+                           Halide::TailStrategy::GuardWithIf)
+                    .split(y, y, yi, rows_per_task,
+                           Halide::TailStrategy::GuardWithIf);
+
+            if (layout == PhotogLayout::Planar) {
+                output.reorder(xi, c, x, yi, y);
+            } else if (layout == PhotogLayout::Interleaved) {
+                // Channels innermost so that stores are dense.
+                output.reorder(c, xi, x, yi, y);
+            }
+
+            output.vectorize(xi)
+                    .unroll(c)
+                    .parallel(y);
+            pixel.compute_at(output, x)
+                    .vectorize(pixel.args()[0], vector_size,
+                               Halide::TailStrategy::GuardWithIf);
+        }
     };
 } // namespace photog
 
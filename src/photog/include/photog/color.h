@@ -1,6 +1,8 @@
 #ifndef PHOTOG_COLOR_H
 #define PHOTOG_COLOR_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -13,6 +15,87 @@ enum PhotogChromadaptMethod {
     Bradford
 };
 
+/** Memory layouts of images.
+ *
+ * Planar images store each channel as a contiguous plane. Interleaved images
+ * store the channels of each pixel contiguously (e.g. RGBRGB...).
+ */
+enum PhotogLayout {
+    Planar,
+    Interleaved
+};
+
+/** Element types of images.
+ *
+ * Float16 elements are IEEE 754 half-precision floats. photog computes in
+ * 32-bit floats, converting half-precision elements as they are loaded and
+ * stored. Float16 images are accepted by color space conversions, illuminant
+ * estimation with every pixel, and chromatic adaptation by
+ * photog_chromadapt_image, its estimator and diy variants and streaming.
+ * Other functions abort on them.
+ */
+enum PhotogElementType {
+    Float32,
+    Uint8,
+    Uint16,
+    Float16
+};
+
+/** Alpha channels of images.
+ *
+ * Images with alpha have a fourth channel after their color channels (e.g.
+ * RGBA). photog copies alpha from input to output unchanged. Images with
+ * alpha must be interleaved, and use exact transfer functions at every
+ * accuracy tier.
+ */
+enum PhotogAlpha {
+    /** No alpha channel. Images have 3 channels. */
+    Opaque,
+    /** Alpha independent of the color channels. */
+    Straight,
+    /** Alpha that the color channels have been multiplied by. Colors are
+     * divided by alpha before processing and multiplied by it again after.
+     */
+    Premultiplied
+};
+
+/** Describes an image already in memory, so that photog can work on it in
+ * place.
+ *
+ * Strides allow for padded rows and for both layouts. Planar images need an x
+ * stride of 1. Interleaved images need an x stride equal to their channel
+ * count (3, or 4 with alpha) and a c stride of 1. The offset and extent
+ * select a region of interest within the image, which is the only part
+ * photog reads or writes.
+ */
+struct PhotogImage {
+    /** Pointer to element (0, 0, 0) of the image. */
+    void *data;
+    /** Type of each element. */
+    PhotogElementType type;
+    /** Distance in elements between neighbouring x, y and c coordinates. */
+    int stride[3];
+    /** x and y coordinates of the region of interest's top-left pixel. */
+    int offset[2];
+    /** Width and height (in pixels) of the region of interest. */
+    int extent[2];
+    /** Alpha channel of the image (see @ref PhotogAlpha "alpha channels").
+     * Zero-initialized descriptors have none. */
+    PhotogAlpha alpha;
+};
+
+/** Accuracy tiers for transfer functions (gamma encoding/decoding).
+ *
+ * Exact evaluates powers with the standard library's precision. Fast uses
+ * polynomial approximations that stay within 3.7e-6 of exact results for
+ * values between 0 and 1 (less than 0.25 LSB at 16 bits) with the sRGB
+ * working space.
+ */
+enum PhotogAccuracy {
+    Exact,
+    Fast
+};
+
 /** Standard illuminants of various vintages.
  *
  * References:
@@ -41,6 +124,27 @@ enum PhotogIlluminant {
     F11     // tri-band @ 4000K
 };
 
+/** Methods of estimating the illuminant of an image from its pixels.
+ *
+ * Each assumes that some statistic of a scene is achromatic, so that the
+ * statistic's color is the illuminant's. Gray-world reads the image once for
+ * its means; the other three statistics are gathered together in another
+ * single read. Means and norms are all normalized by the number of color
+ * elements, so that shades-of-gray with a norm of 1 equals gray-world.
+ */
+enum PhotogIlluminantEstimator {
+    /** Mean of each channel. */
+    GrayWorld,
+    /** Maximum of each channel (max-RGB). */
+    WhitePatch,
+    /** Minkowski 6-norm of each channel, between gray-world and
+     * white-patch. */
+    ShadesOfGray,
+    /** Minkowski 6-norm of each channel's gradient magnitudes. Estimates
+     * from edges, so flat images have no estimate. */
+    GrayEdge
+};
+
 /** Chromatically adapt RGB input from the given source illuminant to the given
  * destination illuminant.
  *
@@ -50,6 +154,11 @@ enum PhotogIlluminant {
  * Here both the source and destination tristimulus values must be supplied by
  * the user hence the "_diy" prefix.
  *
+ * Images have the layout photog was configured with (PHOTOG_IMAGE_LAYOUT,
+ * planar by default) and are converted with exact transfer functions.
+ * @ref photog_chromadapt_diy_ex "photog_chromadapt_diy_ex" takes both per
+ * call.
+ *
  * @param input pointer to float array containing an RGB image to be adapted.
  * Pixel values should be between 0 and 1.
  *
@@ -80,11 +189,80 @@ void photog_chromadapt_diy(float *input, int width, int height,
                            PhotogChromadaptMethod chromadapt_method,
                            float *dest_tristimulus, float *output);
 
+/** @ref photog_chromadapt_diy "photog_chromadapt_diy" with the image layout
+ * and transfer function accuracy chosen per call.
+ *
+ * @param layout memory layout of the input and output images (see
+ * @ref PhotogLayout "layouts").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * See @ref photog_chromadapt_diy "photog_chromadapt_diy" for other parameters.
+ */
+void photog_chromadapt_diy_ex(float *input, int width, int height,
+                              PhotogLayout layout,
+                              float *source_tristimulus,
+                              PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              float *dest_tristimulus, PhotogAccuracy accuracy,
+                              float *output);
+
+/** @ref photog_chromadapt_diy_ex "photog_chromadapt_diy_ex" for 8-bit
+ * images.
+ *
+ * Pixel values span the full range of uint8_t. Normalization and quantization
+ * happen within the adaptation pipeline, so no float copies of the image are
+ * made.
+ */
+void photog_chromadapt_diy_u8(uint8_t *input, int width, int height,
+                              PhotogLayout layout,
+                              float *source_tristimulus,
+                              PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              float *dest_tristimulus, PhotogAccuracy accuracy,
+                              uint8_t *output);
+
+/** @ref photog_chromadapt_diy_ex "photog_chromadapt_diy_ex" for 16-bit
+ * images.
+ *
+ * Pixel values span the full range of uint16_t. Normalization and
+ * quantization happen within the adaptation pipeline, so no float copies of
+ * the image are made.
+ */
+void photog_chromadapt_diy_u16(uint16_t *input, int width, int height,
+                               PhotogLayout layout,
+                               float *source_tristimulus,
+                               PhotogWorkingSpace working_space,
+                               PhotogChromadaptMethod chromadapt_method,
+                               float *dest_tristimulus, PhotogAccuracy accuracy,
+                               uint16_t *output);
+
+/** @ref photog_chromadapt_diy_ex "photog_chromadapt_diy_ex" for
+ * half-precision float images.
+ *
+ * Elements are IEEE 754 half-precision floats, passed as their bits. Pixel
+ * values should be between 0 and 1. Elements are converted to and from
+ * 32-bit floats within the adaptation pipeline, so no float copies of the
+ * image are made.
+ */
+void photog_chromadapt_diy_f16(uint16_t *input, int width, int height,
+                               PhotogLayout layout,
+                               float *source_tristimulus,
+                               PhotogWorkingSpace working_space,
+                               PhotogChromadaptMethod chromadapt_method,
+                               float *dest_tristimulus, PhotogAccuracy accuracy,
+                               uint16_t *output);
+
 /** Chromatically adapt RGB input from the estimated source illuminant of the
  * input image to the given destination illuminant.
  *
  * The source illuminant is estimated using the gray-world method.
  *
+ * Images have the layout photog was configured with (PHOTOG_IMAGE_LAYOUT,
+ * planar by default) and are converted with exact transfer functions.
+ * @ref photog_chromadapt_ex "photog_chromadapt_ex" takes both per call.
+ *
  * We employ the von Kries coefficient law for chromatic adaptation. A cone
  * response under a source illuminant is converted to one under a destination
  * illuminant via diagonal scaling of the cone response components. The output
@@ -125,6 +303,1087 @@ void photog_chromadapt(float *input, int width, int height,
                        PhotogChromadaptMethod chromadapt_method,
                        PhotogIlluminant dest_illuminant, float *output);
 
+/** @ref photog_chromadapt "photog_chromadapt" with the image layout and
+ * transfer function accuracy chosen per call.
+ *
+ * @param layout memory layout of the input and output images (see
+ * @ref PhotogLayout "layouts").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * See @ref photog_chromadapt "photog_chromadapt" for other parameters.
+ */
+void photog_chromadapt_ex(float *input, int width, int height,
+                          PhotogLayout layout,
+                          PhotogWorkingSpace working_space,
+                          PhotogChromadaptMethod chromadapt_method,
+                          PhotogIlluminant dest_illuminant,
+                          PhotogAccuracy accuracy, float *output);
+
+/** @ref photog_chromadapt_ex "photog_chromadapt_ex" for 8-bit images.
+ *
+ * Pixel values span the full range of uint8_t. Normalization and quantization
+ * happen within photog's pipelines, so no float copies of the image are made.
+ */
+void photog_chromadapt_u8(uint8_t *input, int width, int height,
+                          PhotogLayout layout,
+                          PhotogWorkingSpace working_space,
+                          PhotogChromadaptMethod chromadapt_method,
+                          PhotogIlluminant dest_illuminant,
+                          PhotogAccuracy accuracy, uint8_t *output);
+
+/** @ref photog_chromadapt_ex "photog_chromadapt_ex" for 16-bit images.
+ *
+ * Pixel values span the full range of uint16_t. Normalization and
+ * quantization happen within photog's pipelines, so no float copies of the
+ * image are made.
+ */
+void photog_chromadapt_u16(uint16_t *input, int width, int height,
+                           PhotogLayout layout,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy, uint16_t *output);
+
+/** @ref photog_chromadapt_ex "photog_chromadapt_ex" for half-precision float
+ * images.
+ *
+ * Elements are IEEE 754 half-precision floats, passed as their bits. Pixel
+ * values should be between 0 and 1. Elements are converted to and from
+ * 32-bit floats within photog's pipelines, so no float copies of the image
+ * are made.
+ */
+void photog_chromadapt_f16(uint16_t *input, int width, int height,
+                           PhotogLayout layout,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy, uint16_t *output);
+
+/** Chromatically adapt RGB input from the estimated source illuminant of the
+ * input image to the given destination illuminant in a single pass.
+ *
+ * Behaves like @ref photog_chromadapt "photog_chromadapt" but estimates the
+ * source illuminant from a sample of every sample_factor-th pixel in each
+ * dimension. Estimation and adaptation run within one pipeline, so the input
+ * is read in full only once and no host-side work happens between the two.
+ *
+ * @param input pointer to float array containing an RGB image to be adapted.
+ * Pixel values should be between 0 and 1.
+ *
+ * @param width width (in pixels) of the input image.
+ *
+ * @param height height (in pixels) of the input image.
+ *
+ * @param layout memory layout of the input and output images (see
+ * @ref PhotogLayout "layouts").
+ *
+ * @param sample_factor spacing (in pixels) between samples used for source
+ * illuminant estimation. Must be at least 1. A value of 1 samples every
+ * pixel.
+ *
+ * @param working_space working space of the input image (see
+ * @ref PhotogWorkingSpace "working spaces"). Ensures that color space
+ * conversions are accurate.
+ *
+ * @param chromadapt_method method by which input is chromatically-adapted (see
+ * @ref PhotogChromadaptMethod "chromatic adaptation methods").
+ *
+ * @param dest_illuminant destination illuminant for chromatic adaptation (see
+ * @ref PhotogIlluminant "illuminants").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @param output pointer to float array that will receive the chromatically-
+ * adapted RGB image. This array must be equal in size to the input array.
+ * Pixel values will be between 0 and 1.
+ *
+ * @return zero on success, otherwise the Halide error code returned by the
+ * adaptation pipeline.
+ */
+int photog_chromadapt_fused(float *input, int width, int height,
+                            PhotogLayout layout,
+                            int sample_factor,
+                            PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy, float *output);
+
+/** Describe a tightly-packed image covering its full width and height.
+ *
+ * @param data pointer to the first element of the image.
+ *
+ * @param type type of each element.
+ *
+ * @param width width (in pixels) of the image.
+ *
+ * @param height height (in pixels) of the image.
+ *
+ * @param layout memory layout of the image (see @ref PhotogLayout "layouts").
+ */
+PhotogImage photog_make_image(void *data, PhotogElementType type, int width,
+                              int height, PhotogLayout layout);
+
+/** Describe a tightly-packed image with an alpha channel, e.g. RGBA.
+ *
+ * @param alpha alpha channel of the image (see
+ * @ref PhotogAlpha "alpha channels"). Images with alpha have 4 channels.
+ *
+ * See @ref photog_make_image "photog_make_image" for other parameters.
+ */
+PhotogImage photog_make_image_with_alpha(void *data, PhotogElementType type,
+                                         int width, int height,
+                                         PhotogLayout layout,
+                                         PhotogAlpha alpha);
+
+/** Narrow the region of interest of an image.
+ *
+ * The new region must lie within the current region and span at least one
+ * pixel in each dimension.
+ *
+ * @param image image whose region of interest is narrowed.
+ *
+ * @param x x coordinate of the new region's top-left pixel, relative to the
+ * current region.
+ *
+ * @param y y coordinate of the new region's top-left pixel, relative to the
+ * current region.
+ *
+ * @param width width (in pixels) of the new region.
+ *
+ * @param height height (in pixels) of the new region.
+ */
+PhotogImage photog_crop_image(PhotogImage image, int x, int y, int width,
+                              int height);
+
+/** @ref photog_chromadapt_diy "photog_chromadapt_diy" for described images.
+ *
+ * Input and output must share an element type, layout and alpha channel,
+ * and have regions of interest of equal size. Only those regions are read and
+ * written, so padded and cropped images are processed without copies. Alpha
+ * is copied from input to output unchanged.
+ */
+void photog_chromadapt_diy_image(const PhotogImage *input,
+                                 float *source_tristimulus,
+                                 PhotogWorkingSpace working_space,
+                                 PhotogChromadaptMethod chromadapt_method,
+                                 float *dest_tristimulus,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output);
+
+/** @ref photog_chromadapt "photog_chromadapt" for described images.
+ *
+ * The source illuminant is estimated from the input's region of interest.
+ * Requirements on input and output match those of
+ * @ref photog_chromadapt_diy_image "photog_chromadapt_diy_image".
+ */
+void photog_chromadapt_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output);
+
+/** @ref photog_chromadapt_image "photog_chromadapt_image" with a choice of
+ * illuminant estimator.
+ *
+ * @param estimator method of estimating the source illuminant from the
+ * input's region of interest (see
+ * @ref PhotogIlluminantEstimator "illuminant estimators").
+ *
+ * See @ref photog_chromadapt_image "photog_chromadapt_image" for other
+ * parameters.
+ */
+void photog_chromadapt_estimator_image(const PhotogImage *input,
+                                       PhotogIlluminantEstimator estimator,
+                                       PhotogWorkingSpace working_space,
+                                       PhotogChromadaptMethod chromadapt_method,
+                                       PhotogIlluminant dest_illuminant,
+                                       PhotogAccuracy accuracy,
+                                       const PhotogImage *output);
+
+/** Estimate the illuminant of an image.
+ *
+ * The estimate may be passed to
+ * @ref photog_chromadapt_diy_image "photog_chromadapt_diy_image" as its
+ * source tristimulus values.
+ *
+ * @param image descriptor of the image whose region of interest is
+ * estimated from.
+ *
+ * @param estimator method of estimating the illuminant (see
+ * @ref PhotogIlluminantEstimator "illuminant estimators").
+ *
+ * @param working_space RGB working space of the image.
+ *
+ * @param tristimulus pointer to 3 floats receiving the XYZ tristimulus values
+ * of the estimated illuminant.
+ */
+void photog_estimate_illuminant(const PhotogImage *image,
+                                PhotogIlluminantEstimator estimator,
+                                PhotogWorkingSpace working_space,
+                                float *tristimulus);
+
+/** Accuracy of a subsampled illuminant estimate, relative to an estimate
+ * from every pixel.
+ */
+struct PhotogSamplingReport {
+    /** Fraction of the image's pixels that the subsampled estimate read. */
+    float sampled_fraction;
+    /** Angle in degrees between the XYZ tristimulus values of the subsampled
+     * and full estimates (the recovery angular error). */
+    float angular_error;
+};
+
+/** Estimate the illuminant of an image with the gray-world method from a
+ * strided grid of its pixels.
+ *
+ * Only every sample_factor-th pixel of every sample_factor-th row is read,
+ * so estimates take a fraction of the time of
+ * @ref photog_estimate_illuminant "photog_estimate_illuminant". Sample
+ * factors of 4 to 8 suit most photographs.
+ *
+ * @param image descriptor of the image whose region of interest is
+ * estimated from.
+ *
+ * @param sample_factor distance in pixels between samples in each dimension.
+ * Must be at least 1. A factor of 1 reads every pixel.
+ *
+ * @param working_space RGB working space of the image.
+ *
+ * @param tristimulus pointer to 3 floats receiving the XYZ tristimulus values
+ * of the estimated illuminant.
+ *
+ * @param report pointer to a report of the estimate's accuracy, or NULL.
+ * Reports compare against an estimate from every pixel, so they cost a full
+ * read of the image.
+ */
+void photog_estimate_illuminant_sampled(const PhotogImage *image,
+                                        int sample_factor,
+                                        PhotogWorkingSpace working_space,
+                                        float *tristimulus,
+                                        PhotogSamplingReport *report);
+
+/** @ref photog_chromadapt_image "photog_chromadapt_image" with the source
+ * illuminant estimated from a strided grid of pixels.
+ *
+ * See @ref photog_estimate_illuminant_sampled
+ * "photog_estimate_illuminant_sampled" for sample_factor and
+ * @ref photog_chromadapt_image "photog_chromadapt_image" for other
+ * parameters.
+ */
+void photog_chromadapt_sampled_image(const PhotogImage *input,
+                                     int sample_factor,
+                                     PhotogWorkingSpace working_space,
+                                     PhotogChromadaptMethod chromadapt_method,
+                                     PhotogIlluminant dest_illuminant,
+                                     PhotogAccuracy accuracy,
+                                     const PhotogImage *output);
+
+/** @ref photog_chromadapt_fused "photog_chromadapt_fused" for described
+ * images.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_chromadapt_diy_image "photog_chromadapt_diy_image", and results
+ * are returned as by @ref photog_chromadapt_fused "photog_chromadapt_fused".
+ */
+int photog_chromadapt_fused_image(const PhotogImage *input,
+                                  int sample_factor,
+                                  PhotogWorkingSpace working_space,
+                                  PhotogChromadaptMethod chromadapt_method,
+                                  PhotogIlluminant dest_illuminant,
+                                  PhotogAccuracy accuracy,
+                                  const PhotogImage *output);
+
+/** Chromatically adapt a batch of RGB images from their estimated source
+ * illuminants to the given destination illuminant.
+ *
+ * Each image is adapted as by
+ * @ref photog_chromadapt_image "photog_chromadapt_image". Images may differ
+ * in size, element type and layout, though each input must match its output.
+ * Images are processed in parallel with each other and internally, and
+ * per-call setup is shared across the batch, so batches of small images run
+ * much faster than one call per image. A 4-D x, y, c, n buffer is processed
+ * by describing each of its images.
+ *
+ * @param inputs array of count descriptors of images to be adapted.
+ *
+ * @param count number of images in the batch.
+ *
+ * @param working_space working space of the input images (see
+ * @ref PhotogWorkingSpace "working spaces").
+ *
+ * @param chromadapt_method method by which inputs are chromatically-adapted
+ * (see @ref PhotogChromadaptMethod "chromatic adaptation methods").
+ *
+ * @param dest_illuminant destination illuminant for chromatic adaptation (see
+ * @ref PhotogIlluminant "illuminants").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @param outputs array of count descriptors of images that will receive the
+ * chromatically-adapted images.
+ *
+ * @return zero on success, otherwise the first non-zero Halide error code
+ * returned while adapting an image. Other images of the batch may still have
+ * been adapted.
+ */
+int photog_chromadapt_batch(const PhotogImage *inputs, int count,
+                            PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy,
+                            const PhotogImage *outputs);
+
+/** Precomputed state for chromatically adapting many images with the same
+ * settings.
+ *
+ * Create a plan once per working space, chromatic adaptation method,
+ * destination illuminant and accuracy. Executing a plan performs no matrix
+ * set-up and no heap allocation on the host, so per-call overhead stays low
+ * for small images.
+ */
+typedef struct PhotogChromadaptPlan PhotogChromadaptPlan;
+
+/** Create a plan for @ref photog_chromadapt_plan_execute
+ * "photog_chromadapt_plan_execute".
+ *
+ * @param working_space working space of images to be adapted (see
+ * @ref PhotogWorkingSpace "working spaces").
+ *
+ * @param chromadapt_method method by which images are chromatically-adapted
+ * (see @ref PhotogChromadaptMethod "chromatic adaptation methods").
+ *
+ * @param dest_illuminant destination illuminant for chromatic adaptation (see
+ * @ref PhotogIlluminant "illuminants").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @return a plan to be released with @ref photog_chromadapt_plan_destroy
+ * "photog_chromadapt_plan_destroy".
+ */
+PhotogChromadaptPlan *
+photog_chromadapt_plan_create(PhotogWorkingSpace working_space,
+                              PhotogChromadaptMethod chromadapt_method,
+                              PhotogIlluminant dest_illuminant,
+                              PhotogAccuracy accuracy);
+
+/** Chromatically adapt an RGB image from its estimated source illuminant to
+ * a plan's destination illuminant.
+ *
+ * Results match @ref photog_chromadapt_image "photog_chromadapt_image" with
+ * the plan's settings. A plan may be executed from several threads at once.
+ *
+ * @param plan plan created by @ref photog_chromadapt_plan_create
+ * "photog_chromadapt_plan_create".
+ *
+ * @param input descriptor of the image to be adapted.
+ *
+ * @param output descriptor of the image that will receive the
+ * chromatically-adapted image.
+ *
+ * @return zero on success, otherwise the Halide error code returned by the
+ * adaptation pipeline.
+ */
+int photog_chromadapt_plan_execute(PhotogChromadaptPlan *plan,
+                                   const PhotogImage *input,
+                                   const PhotogImage *output);
+
+/** Release a plan created by @ref photog_chromadapt_plan_create
+ * "photog_chromadapt_plan_create".
+ */
+void photog_chromadapt_plan_destroy(PhotogChromadaptPlan *plan);
+
+/** State for chromatically adapting the frames of a video.
+ *
+ * Sessions smooth the estimated source illuminant across frames with an
+ * exponential moving average, so adaptation does not flicker with noise in
+ * per-frame estimates. While the scene is stable, estimates read ever fewer
+ * pixels and are eventually skipped on most frames. The transform applied to
+ * frames is only rebuilt once the smoothed estimate drifts from the one it
+ * was built for.
+ *
+ * Sessions are not thread-safe. Frames must be processed in order.
+ */
+typedef struct PhotogVideoSession PhotogVideoSession;
+
+/** Progress of a video session.
+ */
+struct PhotogVideoReport {
+    /** Frames processed. */
+    int frames;
+    /** Frames whose source illuminant was estimated. */
+    int estimated_frames;
+    /** Times the transform applied to frames was rebuilt. */
+    int transform_updates;
+    /** Sample factor of the next estimate (see
+     * @ref photog_estimate_illuminant_sampled
+     * "photog_estimate_illuminant_sampled"). */
+    int sample_factor;
+    /** Smoothed XYZ tristimulus values of the source illuminant. */
+    float source_tristimulus[3];
+};
+
+/** Create a session for @ref photog_video_session_process
+ * "photog_video_session_process".
+ *
+ * @param working_space working space of frames (see
+ * @ref PhotogWorkingSpace "working spaces").
+ *
+ * @param chromadapt_method method by which frames are chromatically-adapted
+ * (see @ref PhotogChromadaptMethod "chromatic adaptation methods").
+ *
+ * @param dest_illuminant destination illuminant for chromatic adaptation (see
+ * @ref PhotogIlluminant "illuminants").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @param smoothing weight of each new estimate in the moving average, from
+ * just above 0 (heavy smoothing) to 1 (no smoothing).
+ *
+ * @param drift_threshold angle in degrees that the smoothed estimate may
+ * drift before the transform is rebuilt. Estimates within this angle of the
+ * smoothed estimate mark the scene as stable.
+ *
+ * @return a session to be released with @ref photog_video_session_destroy
+ * "photog_video_session_destroy".
+ */
+PhotogVideoSession *
+photog_video_session_create(PhotogWorkingSpace working_space,
+                            PhotogChromadaptMethod chromadapt_method,
+                            PhotogIlluminant dest_illuminant,
+                            PhotogAccuracy accuracy, float smoothing,
+                            float drift_threshold);
+
+/** Chromatically adapt the next frame of a video from the session's smoothed
+ * source illuminant to its destination illuminant.
+ *
+ * The first frame is estimated from every pixel. Frames may change size,
+ * element type, layout or alpha between calls.
+ *
+ * @param session session created by @ref photog_video_session_create
+ * "photog_video_session_create".
+ *
+ * @param input descriptor of the frame to be adapted.
+ *
+ * @param output descriptor of the image that will receive the
+ * chromatically-adapted frame.
+ */
+void photog_video_session_process(PhotogVideoSession *session,
+                                  const PhotogImage *input,
+                                  const PhotogImage *output);
+
+/** Report the progress of a video session.
+ *
+ * @param session session created by @ref photog_video_session_create
+ * "photog_video_session_create".
+ *
+ * @param report pointer to a report receiving the session's progress.
+ */
+void photog_video_session_report(const PhotogVideoSession *session,
+                                 PhotogVideoReport *report);
+
+/** Release a session created by @ref photog_video_session_create
+ * "photog_video_session_create".
+ */
+void photog_video_session_destroy(PhotogVideoSession *session);
+
+/** Fills a strip of rows with pixels of a streamed image.
+ *
+ * @param user_context pointer passed to the streaming function.
+ *
+ * @param y row of the streamed image that the strip starts at.
+ *
+ * @param strip descriptor of photog-owned memory receiving rows
+ * [y, y + strip->extent[1]). Its element type and layout match the image's.
+ *
+ * @return zero on success. Non-zero values stop streaming.
+ */
+typedef int (*PhotogReadStrip)(void *user_context, int y,
+                               const PhotogImage *strip);
+
+/** Receives a strip of rows of a streamed output image.
+ *
+ * @param user_context pointer passed to the streaming function.
+ *
+ * @param y row of the streamed image that the strip starts at.
+ *
+ * @param strip descriptor of photog-owned memory holding rows
+ * [y, y + strip->extent[1]). Only valid until the function returns.
+ *
+ * @return zero on success. Non-zero values stop streaming.
+ */
+typedef int (*PhotogWriteStrip)(void *user_context, int y,
+                                const PhotogImage *strip);
+
+/** Chromatically adapt an RGB image that is streamed in strips of rows from
+ * its estimated source illuminant to a destination illuminant.
+ *
+ * Results match @ref photog_chromadapt "photog_chromadapt" without holding
+ * the whole image in memory. The source illuminant is estimated in a first
+ * pass over every strip, and strips are then adapted in a second pass.
+ * Memory use is bounded by two strips.
+ *
+ * @param read reads each strip. Called for every strip once per pass, in
+ * order of y.
+ *
+ * @param write receives each adapted strip, in order of y.
+ *
+ * @param user_context pointer passed to read and write.
+ *
+ * @param width width (in pixels) of the image.
+ *
+ * @param height height (in pixels) of the image.
+ *
+ * @param type element type of the image (see
+ * @ref PhotogElementType "element types").
+ *
+ * @param layout memory layout of strips (see @ref PhotogLayout "layouts").
+ *
+ * @param strip_height rows per strip. Taller strips parallelize better.
+ *
+ * @param working_space working space of the image (see
+ * @ref PhotogWorkingSpace "working spaces").
+ *
+ * @param chromadapt_method method by which the image is chromatically-adapted
+ * (see @ref PhotogChromadaptMethod "chromatic adaptation methods").
+ *
+ * @param dest_illuminant destination illuminant for chromatic adaptation (see
+ * @ref PhotogIlluminant "illuminants").
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @return zero on success, otherwise the first non-zero value returned by
+ * read or write.
+ */
+int photog_chromadapt_stream(PhotogReadStrip read, PhotogWriteStrip write,
+                             void *user_context, int width, int height,
+                             PhotogElementType type, PhotogLayout layout,
+                             int strip_height,
+                             PhotogWorkingSpace working_space,
+                             PhotogChromadaptMethod chromadapt_method,
+                             PhotogIlluminant dest_illuminant,
+                             PhotogAccuracy accuracy);
+
+/** Chromatically adapt an RGB image file in photog's raw format from its
+ * estimated source illuminant to a destination illuminant, streaming it in
+ * strips of rows.
+ *
+ * photog's raw format is the one written by photog::io: a 64-byte header
+ * giving the image's size, element type and layout, followed by pixel values
+ * in native byte order. Files must have 3 channels. The output file has the
+ * same header. See @ref photog_chromadapt_stream "photog_chromadapt_stream".
+ *
+ * @param input_path path of the image file to be adapted.
+ *
+ * @param output_path path of the file that will receive the
+ * chromatically-adapted image. Must differ from input_path.
+ *
+ * @return zero on success, otherwise non-zero if a file could not be opened,
+ * read or written, or the input file is not a 3-channel raw image.
+ */
+int photog_chromadapt_file(const char *input_path, const char *output_path,
+                           int strip_height,
+                           PhotogWorkingSpace working_space,
+                           PhotogChromadaptMethod chromadapt_method,
+                           PhotogIlluminant dest_illuminant,
+                           PhotogAccuracy accuracy);
+
+/** Scale of XYZ values held in integer images. An element holding the
+ * largest value of its type represents 1 / PHOTOG_INTEGER_XYZ_SCALE, so white
+ * points, whose X and Z reach about 1.1, are stored without saturating.
+ * Conversions to and from XYZ both apply it. */
+#define PHOTOG_INTEGER_XYZ_SCALE 0.5f
+
+/** Convert sRGB input to linear RGB with the sRGB transfer function.
+ *
+ * Color space conversions accept any element type, layout and alpha channel.
+ * Input and output must share all three, and have regions of interest of
+ * equal size. Alpha is copied unchanged. Output may describe the same image as
+ * input, in which case the image is converted in place; images that only
+ * partially overlap are not supported. Integer XYZ images hold values
+ * multiplied by PHOTOG_INTEGER_XYZ_SCALE.
+ *
+ * @param input descriptor of the image to be converted.
+ *
+ * @param accuracy accuracy of transfer functions (see
+ * @ref PhotogAccuracy "accuracy tiers").
+ *
+ * @param output descriptor of the image that will receive the converted
+ * image.
+ */
+void photog_srgb_to_linear_image(const PhotogImage *input,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output);
+
+/** Convert an sRGB image to linear RGB in place.
+ *
+ * Equivalent to @ref photog_srgb_to_linear_image
+ * "photog_srgb_to_linear_image" with image as both input and output, so no
+ * second image is needed.
+ */
+void photog_srgb_to_linear_in_place(const PhotogImage *image,
+                                    PhotogAccuracy accuracy);
+
+/** Convert linear RGB input to sRGB with the sRGB transfer function.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ */
+void photog_linear_to_srgb_image(const PhotogImage *input,
+                                 PhotogAccuracy accuracy,
+                                 const PhotogImage *output);
+
+/** @ref photog_linear_to_srgb_image "photog_linear_to_srgb_image" in place.
+ */
+void photog_linear_to_srgb_in_place(const PhotogImage *image,
+                                    PhotogAccuracy accuracy);
+
+/** Convert RGB input to linear RGB with the gamma of its working space.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ *
+ * @param working_space working space of the RGB image (see
+ * @ref PhotogWorkingSpace "working spaces").
+ */
+void photog_rgb_to_linear_image(const PhotogImage *input,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy,
+                                const PhotogImage *output);
+
+/** @ref photog_rgb_to_linear_image "photog_rgb_to_linear_image" in place.
+ */
+void photog_rgb_to_linear_in_place(const PhotogImage *image,
+                                   PhotogWorkingSpace working_space,
+                                   PhotogAccuracy accuracy);
+
+/** Convert linear RGB input to RGB with the gamma of a working space.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ *
+ * @param working_space working space of the RGB image (see
+ * @ref PhotogWorkingSpace "working spaces").
+ */
+void photog_linear_to_rgb_image(const PhotogImage *input,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy,
+                                const PhotogImage *output);
+
+/** @ref photog_linear_to_rgb_image "photog_linear_to_rgb_image" in place.
+ */
+void photog_linear_to_rgb_in_place(const PhotogImage *image,
+                                   PhotogWorkingSpace working_space,
+                                   PhotogAccuracy accuracy);
+
+/** Convert sRGB input to CIE XYZ.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ */
+void photog_srgb_to_xyz_image(const PhotogImage *input,
+                              PhotogAccuracy accuracy,
+                              const PhotogImage *output);
+
+/** @ref photog_srgb_to_xyz_image "photog_srgb_to_xyz_image" in place.
+ */
+void photog_srgb_to_xyz_in_place(const PhotogImage *image,
+                                 PhotogAccuracy accuracy);
+
+/** Convert CIE XYZ input to sRGB.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ */
+void photog_xyz_to_srgb_image(const PhotogImage *input,
+                              PhotogAccuracy accuracy,
+                              const PhotogImage *output);
+
+/** @ref photog_xyz_to_srgb_image "photog_xyz_to_srgb_image" in place.
+ */
+void photog_xyz_to_srgb_in_place(const PhotogImage *image,
+                                 PhotogAccuracy accuracy);
+
+/** Convert RGB input in a working space to CIE XYZ.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ *
+ * @param working_space working space of the RGB image (see
+ * @ref PhotogWorkingSpace "working spaces").
+ */
+void photog_rgb_to_xyz_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output);
+
+/** @ref photog_rgb_to_xyz_image "photog_rgb_to_xyz_image" in place.
+ */
+void photog_rgb_to_xyz_in_place(const PhotogImage *image,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy);
+
+/** Convert CIE XYZ input to RGB in a working space.
+ *
+ * Requirements on input and output match those of
+ * @ref photog_srgb_to_linear_image "photog_srgb_to_linear_image".
+ *
+ * @param working_space working space of the RGB image (see
+ * @ref PhotogWorkingSpace "working spaces").
+ */
+void photog_xyz_to_rgb_image(const PhotogImage *input,
+                             PhotogWorkingSpace working_space,
+                             PhotogAccuracy accuracy,
+                             const PhotogImage *output);
+
+/** @ref photog_xyz_to_rgb_image "photog_xyz_to_rgb_image" in place.
+ */
+void photog_xyz_to_rgb_in_place(const PhotogImage *image,
+                                PhotogWorkingSpace working_space,
+                                PhotogAccuracy accuracy);
+
+/** Number of equal-width bins in the histograms of PhotogImageStatistics. */
+#define PHOTOG_HISTOGRAM_BINS 256
+
+/** Statistics of each color channel of an image.
+ *
+ * Values are normalized as in photog's pipelines: integer elements are
+ * scaled from their type's full range to between 0 and 1.
+ */
+struct PhotogImageStatistics {
+    /** Pixels whose values fall in each bin. Bin i holds values in
+     * [i / PHOTOG_HISTOGRAM_BINS, (i + 1) / PHOTOG_HISTOGRAM_BINS). Values
+     * below 0 are counted in the first bin and values of 1 or more in the
+     * last. */
+    uint32_t histogram[3][PHOTOG_HISTOGRAM_BINS];
+    /** Smallest value. */
+    float min[3];
+    /** Largest value. */
+    float max[3];
+    /** Pixels with values of 0 or less. */
+    uint32_t clipped_low[3];
+    /** Pixels with values of 1 or more. */
+    uint32_t clipped_high[3];
+};
+
+/** Gather histograms and statistics of the region of interest of an image.
+ *
+ * Everything is gathered in a single parallel read of the image. Rows are
+ * split into strips that each fill their own partial histograms, which are
+ * merged once all strips are done. Alpha is ignored, and premultiplied
+ * colors are divided by alpha first.
+ *
+ * @param image descriptor of the image to be measured.
+ *
+ * @param statistics pointer to the statistics to be filled.
+ */
+void photog_image_statistics(const PhotogImage *image,
+                             PhotogImageStatistics *statistics);
+
+/** Estimate a percentile of a channel from its histogram.
+ *
+ * Values are interpolated linearly within bins, so estimates are within a
+ * bin width of exact. Estimates never exceed the channel's extrema.
+ *
+ * @param statistics statistics filled by
+ * @ref photog_image_statistics "photog_image_statistics".
+ *
+ * @param channel channel of interest (0, 1 or 2).
+ *
+ * @param percentile percentile of interest, between 0 and 100.
+ *
+ * @return estimated value below which percentile percent of the channel's
+ * values fall.
+ */
+float photog_statistics_percentile(const PhotogImageStatistics *statistics,
+                                   int channel, float percentile);
+
+/** A 3D lookup table baked from a per-pixel color transform.
+ *
+ * Tables sample a transform on a grid spanning 0 to 1 in each channel and
+ * interpolate between samples, so chains of conversions cost a few table
+ * reads per pixel instead of their transfer functions and matrices.
+ */
+typedef struct PhotogLut PhotogLut;
+
+/** Evaluates a color transform for @ref photog_lut_bake "photog_lut_bake".
+ *
+ * @param user_context pointer passed to photog_lut_bake.
+ *
+ * @param input descriptor of a planar Float32 image holding the grid.
+ *
+ * @param output descriptor of a planar Float32 image of equal size receiving
+ * the transformed grid.
+ */
+typedef void (*PhotogLutTransform)(void *user_context,
+                                   const PhotogImage *input,
+                                   const PhotogImage *output);
+
+/** Bake a color transform into a 3D lookup table.
+ *
+ * The transform is called once with a grid of every combination of size
+ * evenly-spaced values from 0 to 1 in each channel. It may chain any of
+ * photog's functions, but each output pixel must depend only on its input
+ * pixel: functions that estimate an illuminant from their input (e.g.
+ * @ref photog_chromadapt_image "photog_chromadapt_image") would estimate it
+ * from the grid instead of the images the table is applied to. Use
+ * @ref photog_chromadapt_diy_image "photog_chromadapt_diy_image" with an
+ * estimate instead.
+ *
+ * @param size samples per channel, at least 2. 33 and 65 are common
+ * choices. Interpolation error falls with the square of the spacing of
+ * samples while tables grow with its cube.
+ *
+ * @param transform transform to be baked.
+ *
+ * @param user_context pointer passed to transform.
+ *
+ * @return a table to be released with @ref photog_lut_destroy
+ * "photog_lut_destroy".
+ */
+PhotogLut *photog_lut_bake(int size, PhotogLutTransform transform,
+                           void *user_context);
+
+/** Apply a baked color transform to an RGB image.
+ *
+ * Each pixel is interpolated between four samples of the table's grid
+ * (tetrahedral interpolation). Values outside of 0 to 1 are clamped. Input
+ * and output must share dimensions, element type, layout and alpha, and may
+ * describe the same image. Integer images are normalized as in photog's
+ * other functions.
+ *
+ * @param lut table created by @ref photog_lut_bake "photog_lut_bake".
+ *
+ * @param input descriptor of the image to be transformed.
+ *
+ * @param output descriptor of the image that will receive the transformed
+ * image.
+ */
+void photog_lut_apply(const PhotogLut *lut, const PhotogImage *input,
+                      const PhotogImage *output);
+
+/** Release a table created by @ref photog_lut_bake "photog_lut_bake".
+ */
+void photog_lut_destroy(PhotogLut *lut);
+
+/** A unit of parallel work. Runs the index-th iteration of a loop whose state
+ * is held in closure. Returns zero on success.
+ *
+ * Matches Halide's halide_task_t.
+ */
+typedef int (*PhotogTask)(void *user_context, int index, uint8_t *closure);
+
+/** Runs task for each index in [min, min + size), possibly in parallel, and
+ * returns once all have finished. Returns zero on success or the first
+ * non-zero task result.
+ *
+ * Matches Halide's halide_do_par_for_t.
+ */
+typedef int (*PhotogDoParFor)(void *user_context, PhotogTask task, int min,
+                              int size, uint8_t *closure);
+
+/** Runs a single iteration of a parallel loop. Returns the task's result.
+ *
+ * Matches Halide's halide_do_task_t.
+ */
+typedef int (*PhotogDoTask)(void *user_context, PhotogTask task, int index,
+                            uint8_t *closure);
+
+/** Parallelism of photog calls. */
+enum PhotogParallelism {
+    /** Spread work across photog's thread pool (or a custom do_par_for). */
+    Parallel,
+    /** Run all work on the calling thread. */
+    Serial
+};
+
+/** Set the number of threads in photog's thread pool.
+ *
+ * Must be called before photog first runs in parallel to take full effect.
+ *
+ * @param threads number of threads. Zero selects the number of hardware
+ * threads (or the HL_NUM_THREADS environment variable when set).
+ *
+ * @return the previous number of threads.
+ */
+int photog_set_num_threads(int threads);
+
+/** Replace the parallel for-loop photog runs its work with, e.g. to run photog
+ * on an application's own scheduler.
+ *
+ * Only loops that Halide dispatches through its do_par_for are handed over.
+ * Work that Halide runs as parallel tasks (async producers and some nested
+ * parallel loops) stays on Halide's own thread pool. Calls already running
+ * may finish with either loop.
+ *
+ * @param do_par_for the new parallel for-loop, or NULL to restore photog's
+ * thread pool.
+ *
+ * @return the previous parallel for-loop.
+ */
+PhotogDoParFor photog_set_custom_do_par_for(PhotogDoParFor do_par_for);
+
+/** Replace how photog's thread pool runs each iteration of a parallel loop.
+ *
+ * @param do_task the new task runner, or NULL to restore the default.
+ *
+ * @return the previous task runner.
+ */
+PhotogDoTask photog_set_custom_do_task(PhotogDoTask do_task);
+
+/** Set the parallelism of photog calls made from the calling thread.
+ *
+ * Serial calls avoid waking the thread pool, which is often quicker for
+ * small images. Set Serial before a call and restore the returned value after
+ * it to limit a single call. As with @ref photog_set_custom_do_par_for
+ * "photog_set_custom_do_par_for", only loops dispatched through Halide's
+ * do_par_for are affected.
+ *
+ * @param parallelism parallelism of subsequent calls from this thread (see
+ * @ref PhotogParallelism "parallelism").
+ *
+ * @return the thread's previous parallelism.
+ */
+PhotogParallelism
+photog_set_thread_parallelism(PhotogParallelism parallelism);
+
+/** How photog compiles the pipelines it runs. */
+enum PhotogBackend {
+    /** Use pipelines compiled ahead of time for estimated image sizes. */
+    Aot,
+    /** Compile pipelines at first use, auto-scheduled for the image's size
+     * (rounded up to powers of two), layout and host CPU. Recently used
+     * pipelines are cached in memory and their schedules on disk. */
+    Jit
+};
+
+/** Set how photog compiles the pipelines of
+ * @ref photog_chromadapt "photog_chromadapt" and its variants.
+ *
+ * The first JIT call for each rounded image size, layout, element type and
+ * accuracy auto-schedules a pipeline, which can take several seconds.
+ * Schedules are saved to photog's cache directory so that later processes on
+ * the same host skip auto-scheduling. JIT pipelines run on Halide's JIT thread pool, which
+ * the thread settings above do not affect.
+ *
+ * Auto-scheduling loads Halide's Adams2019 plugin from the
+ * PHOTOG_AUTOSCHEDULER_PLUGIN environment variable when set, otherwise from
+ * the directory photog's library is installed in.
+ *
+ * @param backend backend of subsequent calls from all threads (see
+ * @ref PhotogBackend "backends").
+ *
+ * @return the previous backend.
+ */
+PhotogBackend photog_set_backend(PhotogBackend backend);
+
+/** Set the directory that JIT schedules are cached in. It is created when
+ * first needed.
+ *
+ * @param path the cache directory, or NULL to restore the default: the
+ * PHOTOG_CACHE_DIR environment variable when set, otherwise photog within the
+ * user's cache directory.
+ */
+void photog_set_cache_dir(const char *path);
+
+/** Time, thread use and memory of one stage (Halide Func) of a profiled
+ * library, e.g. linear, xyz or adapted.
+ */
+struct PhotogStageProfile {
+    /** Name of the stage. */
+    const char *name;
+    /** Seconds spent computing the stage across all runs, estimated from
+     * periodic samples of the stage each thread is in. */
+    double seconds;
+    /** Average number of threads busy while the stage was computed. */
+    float thread_utilization;
+    /** Peak bytes of heap memory held by the stage. */
+    uint64_t peak_memory;
+    /** Heap allocations made by the stage. */
+    int allocations;
+};
+
+/** Totals of one profiled library.
+ */
+struct PhotogPipelineProfile {
+    /** Name of the library, e.g. photog_chromadapt_impl. Libraries built
+     * for several targets are named after the target that ran. */
+    const char *name;
+    /** Calls made to the library. */
+    int runs;
+    /** Seconds spent in the library across all runs. */
+    double seconds;
+    /** Average number of threads busy while the library ran. */
+    float thread_utilization;
+    /** Peak bytes of heap memory held by the library. */
+    uint64_t peak_memory;
+    /** Heap allocations made by the library. */
+    int allocations;
+    /** Number of entries in stages. */
+    int stage_count;
+    /** Stages that took time or memory, in pipeline order. */
+    const PhotogStageProfile *stages;
+};
+
+/** A snapshot of the profiles of photog's libraries.
+ *
+ * Profiles are only gathered when photog is built with the PHOTOG_PROFILE
+ * CMake option, which compiles every library with Halide's profiler.
+ * Profiled libraries sample the stage each thread is in every millisecond,
+ * which slows them slightly.
+ */
+typedef struct PhotogProfile PhotogProfile;
+
+/** Whether photog was built with the PHOTOG_PROFILE CMake option.
+ *
+ * @return 1 if libraries are profiled and 0 otherwise.
+ */
+int photog_profiling_enabled(void);
+
+/** Capture the profiles of every library that has run since photog started
+ * or since the last @ref photog_profile_reset "photog_profile_reset".
+ *
+ * Pipelines compiled by the JIT backend are not profiled.
+ *
+ * @return a snapshot to be released with @ref photog_profile_destroy
+ * "photog_profile_destroy". Snapshots hold no libraries when profiling is
+ * disabled.
+ */
+PhotogProfile *photog_profile_capture(void);
+
+/** Profiles of the libraries held in a snapshot.
+ *
+ * @param profile snapshot created by @ref photog_profile_capture
+ * "photog_profile_capture".
+ *
+ * @param count pointer to an int receiving the number of profiles.
+ *
+ * @return an array of count profiles, valid until the snapshot is
+ * destroyed.
+ */
+const PhotogPipelineProfile *
+photog_profile_pipelines(const PhotogProfile *profile, int *count);
+
+/** Release a snapshot created by @ref photog_profile_capture
+ * "photog_profile_capture".
+ */
+void photog_profile_destroy(PhotogProfile *profile);
+
+/** Discard the profiles gathered so far, e.g. to profile a single call.
+ *
+ * Resetting frees the statistics that running libraries update without a
+ * lock, so it must only be called while no photog function is running on any
+ * thread. Capturing profiles is safe at any time.
+ */
+void photog_profile_reset(void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
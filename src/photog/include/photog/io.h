@@ -0,0 +1,138 @@
+#ifndef PHOTOG_IO_H
+#define PHOTOG_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "HalideBuffer.h"
+
+#include "photog/color.h"
+
+namespace photog::io {
+    /** Uncompressed image file formats that photog can memory-map.
+     *
+     * Pfm files (Portable FloatMap) hold 1 or 3 channels of Float32 elements,
+     * interleaved, with rows stored bottom to top. Only little-endian files
+     * are supported.
+     *
+     * Pnm files are binary PGM (P5) and PPM (P6) files, holding 1 or 3
+     * channels of Uint8 or Uint16 elements, interleaved. Files hold 16-bit
+     * elements big-endian, so on little-endian hosts they are copied into
+     * memory byte-swapped rather than accessed in place. Use Raw files to
+     * map 16-bit images without copying.
+     *
+     * Raw files are photog's own format: a 64-byte header followed by 1, 3 or
+     * 4 channels of any element type, in either layout and native byte order.
+     */
+    enum Format {
+        Pfm,
+        Pnm,
+        Raw
+    };
+
+    /** An image file mapped into memory.
+     *
+     * Pixels are accessed in place through buffer() and image(). Pages are
+     * only read from disk when touched, so images larger than memory can be
+     * processed through the page cache. The exception is 16-bit Pnm files on
+     * little-endian hosts, whose pixels are copied (see Format).
+     */
+    class MappedImage {
+    public:
+        /** Maps an existing image file, detecting its format from its
+         * header.
+         *
+         * The mapping is private: pixels may be modified in place, e.g. by
+         * using the image as both input and output of photog, without
+         * changing the file.*/
+        static MappedImage open(const std::string &path);
+
+        /** Creates an image file and maps it for writing. Pixels written to
+         * the mapping are saved to the file.
+         *
+         * Pfm and Pnm files must be interleaved.*/
+        static MappedImage create(const std::string &path, Format format,
+                                  PhotogElementType type, int width,
+                                  int height, int channels,
+                                  PhotogLayout layout =
+                                          PhotogLayout::Interleaved);
+
+        MappedImage(MappedImage &&other) noexcept;
+
+        MappedImage &operator=(MappedImage &&other) noexcept;
+
+        MappedImage(const MappedImage &) = delete;
+
+        MappedImage &operator=(const MappedImage &) = delete;
+
+        ~MappedImage();
+
+        /** View of the mapped pixels with dimensions x, y and c. T must match
+         * the image's element type.*/
+        template<typename T>
+        Halide::Runtime::Buffer<T> buffer() const {
+            check_type(halide_type_of<T>());
+            halide_dimension_t shape[3]{{0, width_,    stride_[0]},
+                                        {0, height_,   stride_[1]},
+                                        {0, channels_, stride_[2]}};
+
+            return Halide::Runtime::Buffer<T>{static_cast<T *>(origin_), 3,
+                                              shape};
+        }
+
+        /** Descriptor of the mapped pixels for photog's functions. The image
+         * must have 3 channels, or 4 with a fourth straight alpha channel.*/
+        PhotogImage image() const;
+
+        /** Waits for modified pixels of a created image to reach the disk.
+         * Pixels written before destruction are saved without flushing.
+         *
+         * Copied pixels are written back to the mapping first.*/
+        void flush();
+
+        Format format() const { return format_; }
+
+        PhotogElementType type() const { return type_; }
+
+        PhotogLayout layout() const { return layout_; }
+
+        int width() const { return width_; }
+
+        int height() const { return height_; }
+
+        int channels() const { return channels_; }
+
+    private:
+        MappedImage() = default;
+
+        void locate(size_t data_offset);
+
+        void check_type(halide_type_t type) const;
+
+        void release();
+
+        void *mapping_{nullptr};
+        size_t mapping_size_{0};
+        /** Element (0, 0, 0) of the image.*/
+        void *origin_{nullptr};
+        /** Element (0, 0, 0) of the file. Differs from origin_ only when
+         * elements are byte-swapped.*/
+        void *data_{nullptr};
+        /** Native-order copy of byte-swapped elements.*/
+        std::vector<uint16_t> native_;
+        int stride_[3]{0, 0, 0};
+        Format format_{Raw};
+        PhotogElementType type_{PhotogElementType::Float32};
+        PhotogLayout layout_{PhotogLayout::Interleaved};
+        int width_{0}, height_{0}, channels_{0};
+        /** Whether the mapping is shared with its file.*/
+        bool writable_{false};
+        /** Whether elements are held byte-swapped in the file, and so are
+         * accessed through native_.*/
+        bool swapped_{false};
+    };
+}
+
+#endif // PHOTOG_IO_H
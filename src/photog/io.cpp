@@ -0,0 +1,439 @@
+#include "photog/io.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HalideBuffer.h"
+
+#include "photog/color.h"
+#include "raw_format.h"
+
+namespace photog::io {
+    size_t element_size(PhotogElementType type) {
+        if (type == PhotogElementType::Float32)
+            return sizeof(float);
+        else if (type == PhotogElementType::Uint8)
+            return sizeof(uint8_t);
+        else if (type == PhotogElementType::Uint16 ||
+                 type == PhotogElementType::Float16)
+            return sizeof(uint16_t);
+        else {
+            std::cerr << "Unsupported element type " << static_cast<int>(type)
+                      << " in photog::io::element_size()." << std::endl;
+            abort();
+        }
+    }
+
+    halide_type_t halide_type(PhotogElementType type) {
+        if (type == PhotogElementType::Float32)
+            return halide_type_of<float>();
+        else if (type == PhotogElementType::Uint8)
+            return halide_type_of<uint8_t>();
+        else if (type == PhotogElementType::Uint16)
+            return halide_type_of<uint16_t>();
+        else
+            return halide_type_t{halide_type_float, 16};
+    }
+
+    bool is_little_endian() {
+        const uint16_t one{1};
+        uint8_t first_byte;
+        std::memcpy(&first_byte, &one, 1);
+
+        return first_byte == 1;
+    }
+
+    /** Reads the next whitespace-separated field of a PFM or PNM header,
+     * skipping comments.*/
+    std::string
+    next_field(const char *header, size_t size, size_t &position) {
+        while (position < size) {
+            if (header[position] == '#') {
+                while (position < size && header[position] != '\n')
+                    ++position;
+            } else if (std::isspace(static_cast<unsigned char>(
+                    header[position]))) {
+                ++position;
+            } else {
+                break;
+            }
+        }
+
+        size_t start = position;
+        while (position < size &&
+               !std::isspace(static_cast<unsigned char>(header[position])))
+            ++position;
+
+        if (start == position) {
+            std::cerr << "Truncated image header in photog::io::next_field()."
+                      << std::endl;
+            abort();
+        }
+
+        return {header + start, position - start};
+    }
+
+    /** Parses a positive integer field of a PFM or PNM header.*/
+    int parse_integer(const std::string &field) {
+        int value{0};
+        const char *end = field.data() + field.size();
+        auto [parsed, error] = std::from_chars(field.data(), end, value);
+
+        if (error != std::errc{} || parsed != end || value <= 0) {
+            std::cerr << "Invalid image header field " << field
+                      << " in photog::io::parse_integer()." << std::endl;
+            abort();
+        }
+
+        return value;
+    }
+
+    /** Parses the scale field of a PFM header. std::from_chars is avoided
+     * as not every supported standard library parses floating point with
+     * it.*/
+    double parse_scale(const std::string &field) {
+        char *parsed;
+        double value = std::strtod(field.c_str(), &parsed);
+
+        if (parsed != field.c_str() + field.size() || value == 0.0) {
+            std::cerr << "Invalid image header field " << field
+                      << " in photog::io::parse_scale()." << std::endl;
+            abort();
+        }
+
+        return value;
+    }
+
+    /** Copies count 16-bit elements from from to to, swapping the bytes of
+     * each between native and file order.*/
+    void copy_swapped(const void *from, void *to, size_t count) {
+        const auto *source = static_cast<const uint16_t *>(from);
+        auto *dest = static_cast<uint16_t *>(to);
+        for (size_t i = 0; i < count; ++i)
+            dest[i] = static_cast<uint16_t>((source[i] << 8) |
+                                            (source[i] >> 8));
+    }
+
+    /** Maps the file at path into memory.
+     *
+     * Existing files are mapped privately and size receives their size.
+     * Created files are first resized to size and mapped shared so that
+     * writes reach the file.*/
+    void *map_file(const std::string &path, bool create, size_t &size) {
+        int fd = ::open(path.c_str(),
+                        create ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+        if (fd < 0) {
+            std::cerr << "Unable to open " << path
+                      << " in photog::io::map_file()." << std::endl;
+            abort();
+        }
+
+        bool sized{true};
+        if (create) {
+            sized = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+        } else {
+            struct stat status{};
+            sized = ::fstat(fd, &status) == 0;
+            size = static_cast<size_t>(status.st_size);
+        }
+
+        void *mapping = sized ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                       create ? MAP_SHARED : MAP_PRIVATE, fd,
+                                       0) : MAP_FAILED;
+        ::close(fd);
+
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Unable to map " << path
+                      << " in photog::io::map_file()." << std::endl;
+            abort();
+        }
+
+        return mapping;
+    }
+
+    MappedImage MappedImage::open(const std::string &path) {
+        MappedImage image;
+        image.mapping_ = photog::io::map_file(path, false,
+                                              image.mapping_size_);
+        const char *header = static_cast<const char *>(image.mapping_);
+        size_t size = image.mapping_size_;
+        size_t data_offset;
+
+        if (size >= sizeof(RawHeader) &&
+            std::memcmp(header, raw_magic, sizeof(raw_magic)) == 0) {
+            RawHeader raw;
+            std::memcpy(&raw, header, sizeof(raw));
+            if (raw.byte_order != raw_byte_order_mark) {
+                std::cerr << "Raw image " << path << " has a foreign byte "
+                          << "order in photog::io::MappedImage::open()."
+                          << std::endl;
+                abort();
+            }
+
+            if (raw.type > static_cast<uint32_t>(PhotogElementType::Float16) ||
+                raw.layout > static_cast<uint32_t>(PhotogLayout::Interleaved) ||
+                (raw.channels != 1 && raw.channels != 3 &&
+                 raw.channels != 4) || raw.width == 0 || raw.height == 0 ||
+                raw.width > INT32_MAX || raw.height > INT32_MAX) {
+                std::cerr << "Raw image " << path << " has an invalid "
+                          << "header in photog::io::MappedImage::open()."
+                          << std::endl;
+                abort();
+            }
+
+            image.format_ = Format::Raw;
+            image.type_ = static_cast<PhotogElementType>(raw.type);
+            image.layout_ = static_cast<PhotogLayout>(raw.layout);
+            image.width_ = static_cast<int>(raw.width);
+            image.height_ = static_cast<int>(raw.height);
+            image.channels_ = static_cast<int>(raw.channels);
+            data_offset = sizeof(RawHeader);
+        } else if (size >= 2 && header[0] == 'P' &&
+                   std::string_view{"Ff56"}.find(header[1]) !=
+                   std::string_view::npos) {
+            char kind = header[1];
+            size_t position{2};
+            image.channels_ = kind == 'F' || kind == '6' ? 3 : 1;
+            image.width_ = parse_integer(next_field(header, size, position));
+            image.height_ = parse_integer(next_field(header, size, position));
+            std::string scale_field = next_field(header, size, position);
+            // PNM maximum values are integers.
+            double scale = kind == 'F' || kind == 'f' ?
+                           parse_scale(scale_field) :
+                           parse_integer(scale_field);
+            // A single whitespace character ends the header.
+            data_offset = position + 1;
+
+            if (kind == 'F' || kind == 'f') {
+                // Negative scales mark little-endian files.
+                if (scale > 0.0 || !is_little_endian()) {
+                    std::cerr << "Big-endian PFM image " << path << " in "
+                              << "photog::io::MappedImage::open()."
+                              << std::endl;
+                    abort();
+                }
+                image.format_ = Format::Pfm;
+                image.type_ = PhotogElementType::Float32;
+            } else {
+                if (scale != 255.0 && scale != 65535.0) {
+                    std::cerr << "Unsupported maximum value " << scale
+                              << " of " << path << " in "
+                              << "photog::io::MappedImage::open()."
+                              << std::endl;
+                    abort();
+                }
+                image.format_ = Format::Pnm;
+                image.type_ = scale == 255.0 ? PhotogElementType::Uint8 :
+                              PhotogElementType::Uint16;
+                image.swapped_ = image.type_ == PhotogElementType::Uint16 &&
+                                 is_little_endian();
+            }
+            image.layout_ = PhotogLayout::Interleaved;
+        } else {
+            std::cerr << "Unsupported image format of " << path
+                      << " in photog::io::MappedImage::open()." << std::endl;
+            abort();
+        }
+
+        size_t data_size = static_cast<size_t>(image.width_) * image.height_ *
+                           image.channels_ * element_size(image.type_);
+        if (size < data_offset + data_size) {
+            std::cerr << "Truncated image " << path
+                      << " in photog::io::MappedImage::open()." << std::endl;
+            abort();
+        }
+
+        image.locate(data_offset);
+        if (image.swapped_)
+            copy_swapped(image.data_, image.origin_, image.native_.size());
+
+        return image;
+    }
+
+    MappedImage
+    MappedImage::create(const std::string &path, Format format,
+                        PhotogElementType type, int width, int height,
+                        int channels, PhotogLayout layout) {
+        if ((channels != 1 && channels != 3 && channels != 4) ||
+            (format != Format::Raw &&
+             (channels == 4 || layout != PhotogLayout::Interleaved)) ||
+            (format == Format::Pfm && type != PhotogElementType::Float32) ||
+            (format == Format::Pnm && type != PhotogElementType::Uint8 &&
+             type != PhotogElementType::Uint16)) {
+            std::cerr << "Unsupported image shape for format "
+                      << static_cast<int>(format)
+                      << " in photog::io::MappedImage::create()."
+                      << std::endl;
+            abort();
+        }
+
+        std::string header;
+        if (format == Format::Pfm) {
+            header = std::string{channels == 3 ? "PF" : "Pf"} + "\n" +
+                     std::to_string(width) + " " + std::to_string(height) +
+                     "\n-1.";
+            // The scale is zero-padded so that elements are aligned.
+            while ((header.size() + 1) % sizeof(float) != 0)
+                header += '0';
+            header += '\n';
+        } else if (format == Format::Pnm) {
+            std::string fields =
+                    std::to_string(width) + " " + std::to_string(height) +
+                    "\n" + (type == PhotogElementType::Uint8 ? "255" : "65535") +
+                    "\n";
+            header = channels == 3 ? "P6\n" : "P5\n";
+            // Padded with whitespace so that elements are aligned.
+            while ((header.size() + fields.size()) % element_size(type) != 0)
+                header += '\n';
+            header += fields;
+        } else {
+            RawHeader raw{};
+            std::memcpy(raw.magic, raw_magic, sizeof(raw_magic));
+            raw.byte_order = raw_byte_order_mark;
+            raw.width = static_cast<uint32_t>(width);
+            raw.height = static_cast<uint32_t>(height);
+            raw.channels = static_cast<uint32_t>(channels);
+            raw.type = static_cast<uint32_t>(type);
+            raw.layout = static_cast<uint32_t>(layout);
+            header.assign(reinterpret_cast<const char *>(&raw), sizeof(raw));
+        }
+
+        MappedImage image;
+        image.format_ = format;
+        image.type_ = type;
+        image.layout_ = layout;
+        image.width_ = width;
+        image.height_ = height;
+        image.channels_ = channels;
+        image.writable_ = true;
+        image.swapped_ = format == Format::Pnm &&
+                         type == PhotogElementType::Uint16 &&
+                         is_little_endian();
+        image.mapping_size_ = header.size() +
+                              static_cast<size_t>(width) * height * channels *
+                              element_size(type);
+        image.mapping_ = photog::io::map_file(path, true,
+                                              image.mapping_size_);
+        std::memcpy(image.mapping_, header.data(), header.size());
+        image.locate(header.size());
+
+        return image;
+    }
+
+    MappedImage::MappedImage(MappedImage &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedImage &MappedImage::operator=(MappedImage &&other) noexcept {
+        if (this != &other) {
+            release();
+            mapping_ = std::exchange(other.mapping_, nullptr);
+            mapping_size_ = std::exchange(other.mapping_size_, 0);
+            origin_ = std::exchange(other.origin_, nullptr);
+            data_ = std::exchange(other.data_, nullptr);
+            // Moving keeps the elements in place, so origin_ stays valid.
+            native_ = std::move(other.native_);
+            std::copy(other.stride_, other.stride_ + 3, stride_);
+            format_ = other.format_;
+            type_ = other.type_;
+            layout_ = other.layout_;
+            width_ = other.width_;
+            height_ = other.height_;
+            channels_ = other.channels_;
+            writable_ = other.writable_;
+            swapped_ = other.swapped_;
+        }
+
+        return *this;
+    }
+
+    MappedImage::~MappedImage() {
+        release();
+    }
+
+    PhotogImage MappedImage::image() const {
+        if (channels_ != 3 && channels_ != 4) {
+            std::cerr << "Unsupported channel count " << channels_
+                      << " in photog::io::MappedImage::image()." << std::endl;
+            abort();
+        }
+
+        return PhotogImage{origin_, type_, {stride_[0], stride_[1], stride_[2]},
+                           {0, 0}, {width_, height_},
+                           channels_ == 4 ? PhotogAlpha::Straight
+                                          : PhotogAlpha::Opaque};
+    }
+
+    void MappedImage::flush() {
+        if (!writable_)
+            return;
+
+        if (swapped_)
+            copy_swapped(origin_, data_, native_.size());
+        ::msync(mapping_, mapping_size_, MS_SYNC);
+    }
+
+    /** Finds element (0, 0, 0) and the strides of pixels starting at
+     * data_offset.
+     *
+     * Byte-swapped images are located in a copy of their elements instead,
+     * laid out as in the file.*/
+    void MappedImage::locate(size_t data_offset) {
+        char *data = static_cast<char *>(mapping_) + data_offset;
+
+        if (layout_ == PhotogLayout::Planar) {
+            stride_[0] = 1;
+            stride_[1] = width_;
+            stride_[2] = width_ * height_;
+        } else {
+            stride_[0] = channels_;
+            stride_[1] = width_ * channels_;
+            stride_[2] = 1;
+        }
+
+        // PFM rows are stored bottom to top.
+        if (format_ == Format::Pfm) {
+            data += static_cast<size_t>(height_ - 1) * stride_[1] *
+                    element_size(type_);
+            stride_[1] = -stride_[1];
+        }
+
+        data_ = data;
+        if (swapped_) {
+            native_.resize(static_cast<size_t>(width_) * height_ * channels_);
+            data = reinterpret_cast<char *>(native_.data());
+        }
+        origin_ = data;
+    }
+
+    void MappedImage::check_type(halide_type_t type) const {
+        if (type != photog::io::halide_type(type_)) {
+            std::cerr << "Mismatched element type of mapped image in "
+                      << "photog::io::MappedImage::buffer()." << std::endl;
+            abort();
+        }
+    }
+
+    void MappedImage::release() {
+        if (!mapping_)
+            return;
+
+        if (writable_ && swapped_)
+            copy_swapped(origin_, data_, native_.size());
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+}
@@ -0,0 +1,407 @@
+#include "jit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "Halide.h"
+
+#include "photog/color.h"
+#include "color_funcs.h"
+#include "color_utils.h"
+
+namespace photog {
+    std::atomic<PhotogBackend> backend{PhotogBackend::Aot};
+
+    /** Guards cache_dir and compiled_pipelines. Never held while pipelines
+     * are scheduled or compiled.*/
+    std::mutex jit_mutex;
+
+    /** Directory that schedules are cached in. Empty selects the default.*/
+    std::filesystem::path cache_dir;
+
+    /** Compiled pipelines kept in memory. Least recently used pipelines
+     * beyond this are released.*/
+    const size_t max_compiled_pipelines{32};
+
+    /** A compiled pipeline. Pipelines still being compiled are ready once
+     * their compiling thread finishes, so each key is only compiled once.*/
+    struct CompiledPipeline {
+        std::shared_future<Halide::Callable> callable;
+        /** Position of the key in recently_used.*/
+        std::list<std::string>::iterator use;
+    };
+
+    /** Compiled pipelines by cache key.*/
+    std::map<std::string, CompiledPipeline> compiled_pipelines;
+
+    /** Keys of compiled_pipelines, most recently used first.*/
+    std::list<std::string> recently_used;
+
+    PhotogBackend get_backend() {
+        return backend;
+    }
+
+    std::filesystem::path get_cache_dir() {
+        if (!cache_dir.empty())
+            return cache_dir;
+        else if (const char *dir = std::getenv("PHOTOG_CACHE_DIR"))
+            return dir;
+        else if (const char *dir = std::getenv("XDG_CACHE_HOME"))
+            return std::filesystem::path{dir} / "photog";
+        else if (const char *dir = std::getenv("HOME"))
+            return std::filesystem::path{dir} / ".cache" / "photog";
+        else
+            return std::filesystem::temp_directory_path() / "photog";
+    }
+
+    /** Directory holding the library that photog's code was loaded from.
+     * Empty when it cannot be found.*/
+    std::filesystem::path get_library_dir() {
+        static const char anchor{};
+#ifdef _WIN32
+        HMODULE module{nullptr};
+        char path[MAX_PATH];
+        if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                                GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                &anchor, &module) ||
+            GetModuleFileNameA(module, path, MAX_PATH) == 0)
+            return {};
+
+        return std::filesystem::path{path}.parent_path();
+#else
+        Dl_info info{};
+        if (dladdr(&anchor, &info) == 0 || !info.dli_fname)
+            return {};
+
+        return std::filesystem::path{info.dli_fname}.parent_path();
+#endif
+    }
+
+    /** Path of the Adams2019 auto-scheduler plugin. Taken from the
+     * PHOTOG_AUTOSCHEDULER_PLUGIN environment variable when set, otherwise
+     * from beside photog's library, where it is installed, and finally from
+     * the build tree.*/
+    std::filesystem::path get_autoscheduler_plugin() {
+        if (const char *plugin = std::getenv("PHOTOG_AUTOSCHEDULER_PLUGIN"))
+            return plugin;
+
+        std::filesystem::path installed =
+                photog::get_library_dir() / PHOTOG_AUTOSCHEDULER_PLUGIN_NAME;
+        std::error_code error;
+        if (std::filesystem::exists(installed, error))
+            return installed;
+
+        return PHOTOG_AUTOSCHEDULER_PLUGIN_BUILD_PATH;
+    }
+
+    /** Inputs of a JIT chromatic adaptation pipeline. Mirrors the inputs of
+     * photog_chromadapt_fused_impl.*/
+    struct ChromadaptParams {
+        Halide::ImageParam input;
+        Halide::Param<int> sample_factor{"sample_factor"};
+        Halide::Param<float> gamma{"gamma"};
+        Halide::ImageParam rgb_to_xyz_xfmr{Halide::Float(32), 2,
+                                           "rgb_to_xyz_xfmr"};
+        Halide::ImageParam xyz_to_rgb_xfmr{Halide::Float(32), 2,
+                                           "xyz_to_rgb_xfmr"};
+        Halide::ImageParam xyz_to_lms_xfmr{Halide::Float(32), 2,
+                                           "xyz_to_lms_xfmr"};
+        Halide::ImageParam lms_to_xyz_xfmr{Halide::Float(32), 2,
+                                           "lms_to_xyz_xfmr"};
+        Halide::ImageParam dest_tristimulus{Halide::Float(32), 1,
+                                            "dest_tristimulus"};
+
+        ChromadaptParams(const Halide::Type &type, PhotogLayout layout)
+                : input{type, 3, "input"} {
+            if (layout == PhotogLayout::Interleaved) {
+                input.dim(0).set_stride(3);
+                input.dim(2).set_stride(1);
+            }
+        }
+
+        /** Arguments of the compiled pipeline, in call order.*/
+        std::vector<Halide::Argument> arguments() const {
+            return {input, sample_factor, gamma, rgb_to_xyz_xfmr,
+                    xyz_to_rgb_xfmr, xyz_to_lms_xfmr, lms_to_xyz_xfmr,
+                    dest_tristimulus};
+        }
+
+        /** Parameters that a deserialized pipeline is bound to.*/
+        std::map<std::string, Halide::Internal::Parameter> parameters() const {
+            std::map<std::string, Halide::Internal::Parameter> parameters;
+            for (const Halide::OutputImageParam &image :
+                    {input, rgb_to_xyz_xfmr, xyz_to_rgb_xfmr, xyz_to_lms_xfmr,
+                     lms_to_xyz_xfmr, dest_tristimulus})
+                parameters[image.name()] = image.parameter();
+            parameters[sample_factor.name()] = sample_factor.parameter();
+            parameters[gamma.name()] = gamma.parameter();
+
+            return parameters;
+        }
+    };
+
+    /** Image extent that pipelines are scheduled for: the next power of two
+     * of at least 64. Images of any size run on any schedule, so images of
+     * similar sizes share a schedule instead of each paying for
+     * auto-scheduling and compilation.*/
+    int get_extent_estimate(int extent) {
+        int estimate{64};
+        while (estimate < extent && estimate < (1 << 30))
+            estimate *= 2;
+
+        return estimate;
+    }
+
+    /** Identifies a pipeline scheduled for an image and host. Also names its
+     * cached schedule.*/
+    std::string
+    get_cache_key(const Halide::Type &type, PhotogLayout layout, int width,
+                  int height, PhotogAccuracy accuracy,
+                  const Halide::Target &target, int parallelism) {
+        std::ostringstream key;
+        key << "chromadapt-" << type << "-"
+            << (layout == PhotogLayout::Planar ? "planar" : "interleaved")
+            << "-" << width << "x" << height << "-"
+            << (accuracy == PhotogAccuracy::Fast ? "fast" : "exact") << "-"
+            << target.to_string() << "-" << parallelism << "-halide"
+            << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "."
+            << HALIDE_VERSION_PATCH << "-photog" << PHOTOG_VERSION;
+
+        return key.str();
+    }
+
+    /** Builds the gray-world chromatic adaptation pipeline and auto-schedules
+     * it for an image of the given size.*/
+    Halide::Pipeline
+    schedule_chromadapt(ChromadaptParams &params, PhotogLayout layout,
+                        int width, int height, PhotogAccuracy accuracy,
+                        const Halide::Target &target, int parallelism) {
+        static std::once_flag plugin_loaded;
+        std::call_once(plugin_loaded, []() {
+            Halide::load_plugin(photog::get_autoscheduler_plugin().string());
+        });
+
+        Halide::Func output{"output"};
+        Halide::Var x{"x"}, y{"y"}, c{"c"};
+        const int C{3};
+
+        output(x, y, c) =
+                photog::quantize(
+                        photog::chromadapt_gray_world(
+                                params.input, params.input.width(),
+                                params.input.height(),
+                                params.input.channels(),
+                                params.sample_factor, params.gamma,
+                                params.rgb_to_xyz_xfmr,
+                                params.xyz_to_rgb_xfmr,
+                                params.xyz_to_lms_xfmr,
+                                params.lms_to_xyz_xfmr,
+                                params.dest_tristimulus, accuracy)(x, y, c),
+                        params.input.type());
+
+        params.input.set_estimates({{0, width},
+                                    {0, height},
+                                    {0, C}});
+        params.sample_factor.set_estimate(1);
+        params.gamma.set_estimate(2.2f);
+        for (Halide::ImageParam *xfmr : {&params.rgb_to_xyz_xfmr,
+                                         &params.xyz_to_rgb_xfmr,
+                                         &params.xyz_to_lms_xfmr,
+                                         &params.lms_to_xyz_xfmr})
+            xfmr->set_estimates({{0, C},
+                                 {0, C}});
+        params.dest_tristimulus.set_estimates({{0, C}});
+        output.set_estimates({{0, width},
+                              {0, height},
+                              {0, C}});
+
+        if (layout == PhotogLayout::Interleaved) {
+            output.output_buffer().dim(0).set_stride(C);
+            output.output_buffer().dim(2).set_stride(1);
+        }
+
+        Halide::Pipeline pipeline{output};
+        pipeline.apply_autoscheduler(
+                target, {"Adams2019",
+                         {{"parallelism", std::to_string(parallelism)}}});
+
+        return pipeline;
+    }
+
+    /** Saves a scheduled pipeline. Written to a temporary file first so that
+     * concurrent processes never read a partial file.*/
+    void save_pipeline(const Halide::Pipeline &pipeline,
+                       const std::filesystem::path &path) {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        std::filesystem::path temporary =
+                path.string() + "." + std::to_string(std::random_device{}());
+
+        Halide::serialize_pipeline(pipeline, temporary.string());
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            std::cerr << "Unable to cache pipeline at " << path
+                      << " in photog::save_pipeline()." << std::endl;
+        }
+    }
+
+    /** Loads a pipeline's schedule from the cache directory, or
+     * auto-schedules and caches it, and compiles it.*/
+    Halide::Callable
+    compile_chromadapt(const Halide::Type &type, PhotogLayout layout,
+                       int width, int height, PhotogAccuracy accuracy,
+                       const Halide::Target &target, int parallelism,
+                       const std::filesystem::path &path) {
+        ChromadaptParams params{type, layout};
+        Halide::Pipeline pipeline;
+
+        if (std::filesystem::exists(path)) {
+            try {
+                pipeline = Halide::deserialize_pipeline(path.string(),
+                                                        params.parameters());
+            } catch (const Halide::Error &error) {
+                std::cerr << "Ignoring unreadable cached pipeline " << path
+                          << " in photog::compile_chromadapt(): "
+                          << error.what() << std::endl;
+            }
+        }
+
+        if (!pipeline.defined()) {
+            pipeline = photog::schedule_chromadapt(params, layout, width,
+                                                   height, accuracy, target,
+                                                   parallelism);
+            photog::save_pipeline(pipeline, path);
+        }
+
+        return pipeline.compile_to_callable(params.arguments(), target);
+    }
+
+    /** Compiled chromatic adaptation pipeline for an image, loading its
+     * schedule from the cache directory or auto-scheduling and caching it.
+     *
+     * The first caller of each key compiles its pipeline outside of
+     * jit_mutex. Later callers of the key wait for that compilation, while
+     * callers of other keys proceed.*/
+    Halide::Callable
+    get_chromadapt_pipeline(const Halide::Type &type, PhotogLayout layout,
+                            int width, int height, PhotogAccuracy accuracy) {
+        const Halide::Target target = Halide::get_jit_target_from_environment();
+        const int parallelism =
+                std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        width = photog::get_extent_estimate(width);
+        height = photog::get_extent_estimate(height);
+        std::string key = photog::get_cache_key(type, layout, width, height,
+                                                accuracy, target, parallelism);
+
+        std::promise<Halide::Callable> compiled;
+        std::shared_future<Halide::Callable> pipeline;
+        std::filesystem::path path;
+        {
+            std::lock_guard<std::mutex> lock{jit_mutex};
+            auto cached = compiled_pipelines.find(key);
+            if (cached != compiled_pipelines.end()) {
+                pipeline = cached->second.callable;
+                recently_used.splice(recently_used.begin(), recently_used,
+                                     cached->second.use);
+            } else {
+                pipeline = compiled.get_future().share();
+                recently_used.push_front(key);
+                compiled_pipelines.emplace(
+                        key, CompiledPipeline{pipeline,
+                                              recently_used.begin()});
+                path = photog::get_cache_dir() / (key + ".hlpipe");
+
+                // Callers of released pipelines keep their own futures.
+                if (compiled_pipelines.size() > max_compiled_pipelines) {
+                    compiled_pipelines.erase(recently_used.back());
+                    recently_used.pop_back();
+                }
+            }
+        }
+        // Waits for other threads' compilations without holding the lock.
+        if (path.empty())
+            return pipeline.get();
+
+        try {
+            compiled.set_value(photog::compile_chromadapt(
+                    type, layout, width, height, accuracy, target,
+                    parallelism, path));
+        } catch (...) {
+            // Waiting callers see the failure. Later callers retry.
+            {
+                std::lock_guard<std::mutex> lock{jit_mutex};
+                auto failed = compiled_pipelines.find(key);
+                if (failed != compiled_pipelines.end()) {
+                    recently_used.erase(failed->second.use);
+                    compiled_pipelines.erase(failed);
+                }
+            }
+            compiled.set_exception(std::current_exception());
+        }
+
+        return pipeline.get();
+    }
+
+    void jit_chromadapt(Halide::Runtime::Buffer<> input, PhotogLayout layout,
+                        ChromadaptConstants &constants,
+                        PhotogAccuracy accuracy,
+                        Halide::Runtime::Buffer<> output) {
+        // Exceptions must not cross photog's C interface, so compilation
+        // failures abort like photog's other errors.
+        Halide::Callable pipeline;
+        try {
+            pipeline = photog::get_chromadapt_pipeline(
+                    Halide::Type{input.type()}, layout, input.width(),
+                    input.height(), accuracy);
+        } catch (const std::exception &error) {
+            std::cerr << "JIT pipeline failed to compile in "
+                      << "photog::jit_chromadapt(): " << error.what()
+                      << std::endl;
+            abort();
+        }
+
+        // Sampling every pixel matches the estimate of the AOT backend.
+        int result = pipeline(input.raw_buffer(), 1, constants.gamma,
+                              constants.rgb_to_xyz_xfmr.raw_buffer(),
+                              constants.xyz_to_rgb_xfmr.raw_buffer(),
+                              constants.xyz_to_lms_xfmr.raw_buffer(),
+                              constants.lms_to_xyz_xfmr.raw_buffer(),
+                              constants.dest_tristimulus.raw_buffer(),
+                              output.raw_buffer());
+        if (result != 0) {
+            std::cerr << "JIT pipeline failed with error " << result
+                      << " in photog::jit_chromadapt()." << std::endl;
+            abort();
+        }
+    }
+}
+
+PhotogBackend photog_set_backend(PhotogBackend backend) {
+    return photog::backend.exchange(backend);
+}
+
+void photog_set_cache_dir(const char *path) {
+    std::lock_guard<std::mutex> lock{photog::jit_mutex};
+    photog::cache_dir = path ? path : "";
+}
@@ -0,0 +1,18 @@
+#ifndef PHOTOG_JIT_H
+#define PHOTOG_JIT_H
+
+#include "Halide.h"
+
+#include "photog/color.h"
+#include "color_utils.h"
+
+namespace photog {
+    PhotogBackend get_backend();
+
+    void jit_chromadapt(Halide::Runtime::Buffer<> input, PhotogLayout layout,
+                        ChromadaptConstants &constants,
+                        PhotogAccuracy accuracy,
+                        Halide::Runtime::Buffer<> output);
+}
+
+#endif // PHOTOG_JIT_H
@@ -0,0 +1,66 @@
+#include "photog/color.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "HalideRuntime.h"
+
+namespace photog {
+    /** Parallelism of photog calls made from each thread.*/
+    thread_local PhotogParallelism thread_parallelism{
+            PhotogParallelism::Parallel};
+
+    /** Parallel for-loop that photog hands work to when parallel. Atomic as
+     * it may be replaced while pipelines run.*/
+    std::atomic<halide_do_par_for_t> parallel_do_par_for{
+            halide_default_do_par_for};
+
+    /** Runs tasks on the calling thread when it asked for serial execution
+     * and hands them to parallel_do_par_for otherwise.
+     *
+     * Installed as Halide's do_par_for, so it only sees loops that Halide
+     * dispatches through do_par_for. Loops that Halide lowers to
+     * halide_do_parallel_tasks (async producers and some nested parallel
+     * loops) still run on Halide's own thread pool.*/
+    int do_par_for(void *user_context, halide_task_t task, int min, int size,
+                   uint8_t *closure) {
+        if (thread_parallelism == PhotogParallelism::Serial) {
+            for (int x = min; x < min + size; ++x) {
+                int result = task(user_context, x, closure);
+                if (result != 0)
+                    return result;
+            }
+
+            return 0;
+        }
+
+        return parallel_do_par_for.load()(user_context, task, min, size,
+                                          closure);
+    }
+}
+
+int photog_set_num_threads(int threads) {
+    return halide_set_num_threads(threads);
+}
+
+PhotogDoParFor photog_set_custom_do_par_for(PhotogDoParFor do_par_for) {
+    PhotogDoParFor previous = photog::parallel_do_par_for.exchange(
+            do_par_for ? do_par_for : halide_default_do_par_for);
+    halide_set_custom_do_par_for(photog::do_par_for);
+
+    return previous;
+}
+
+PhotogDoTask photog_set_custom_do_task(PhotogDoTask do_task) {
+    return halide_set_custom_do_task(do_task ? do_task :
+                                     halide_default_do_task);
+}
+
+PhotogParallelism
+photog_set_thread_parallelism(PhotogParallelism parallelism) {
+    PhotogParallelism previous = photog::thread_parallelism;
+    photog::thread_parallelism = parallelism;
+    halide_set_custom_do_par_for(photog::do_par_for);
+
+    return previous;
+}
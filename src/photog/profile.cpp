@@ -0,0 +1,109 @@
+#include "photog/color.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "HalideRuntime.h"
+
+struct PhotogProfile {
+    std::vector<PhotogPipelineProfile> pipelines;
+    std::vector<std::vector<PhotogStageProfile>> stages;
+    /** Copies of names. A deque keeps them in place as it grows.*/
+    std::deque<std::string> names;
+};
+
+namespace photog {
+#ifdef PHOTOG_PROFILE
+    /** Average number of threads active from Halide's running totals.*/
+    float utilization(uint64_t numerator, uint64_t denominator) {
+        return denominator == 0 ? 0.0f :
+               static_cast<float>(static_cast<double>(numerator) /
+                                  denominator);
+    }
+
+    /** Copies the statistics of every library that has run out of Halide's
+     * profiler state. Stages that took neither time nor memory are left out,
+     * as in Halide's own reports.*/
+    void capture_profiles(PhotogProfile &profile) {
+        const double seconds_per_nanosecond{1e-9};
+        halide_profiler_state *state = halide_profiler_get_state();
+
+        halide_mutex_lock(&state->lock);
+        for (auto pipeline = state->pipelines; pipeline;
+             pipeline = static_cast<halide_profiler_pipeline_stats *>(
+                     pipeline->next)) {
+            if (pipeline->runs == 0)
+                continue;
+
+            std::vector<PhotogStageProfile> stages;
+            for (int i = 0; i < pipeline->num_funcs; ++i) {
+                const halide_profiler_func_stats &func = pipeline->funcs[i];
+                if (func.time == 0 && func.memory_total == 0)
+                    continue;
+
+                profile.names.emplace_back(func.name);
+                stages.push_back(
+                        {profile.names.back().c_str(),
+                         func.time * seconds_per_nanosecond,
+                         photog::utilization(func.active_threads_numerator,
+                                             func.active_threads_denominator),
+                         func.memory_peak, func.num_allocs});
+            }
+
+            profile.names.emplace_back(pipeline->name);
+            profile.pipelines.push_back(
+                    {profile.names.back().c_str(), pipeline->runs,
+                     pipeline->time * seconds_per_nanosecond,
+                     photog::utilization(pipeline->active_threads_numerator,
+                                         pipeline->active_threads_denominator),
+                     pipeline->memory_peak, pipeline->num_allocs,
+                     static_cast<int>(stages.size()), nullptr});
+            profile.stages.push_back(std::move(stages));
+        }
+        halide_mutex_unlock(&state->lock);
+
+        // Stages are only pointed to once their vectors stop moving.
+        for (size_t i = 0; i < profile.pipelines.size(); ++i)
+            profile.pipelines[i].stages = profile.stages[i].data();
+    }
+#endif
+}
+
+int photog_profiling_enabled(void) {
+#ifdef PHOTOG_PROFILE
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+PhotogProfile *photog_profile_capture(void) {
+    auto profile = new PhotogProfile{};
+#ifdef PHOTOG_PROFILE
+    photog::capture_profiles(*profile);
+#endif
+
+    return profile;
+}
+
+const PhotogPipelineProfile *
+photog_profile_pipelines(const PhotogProfile *profile, int *count) {
+    *count = static_cast<int>(profile->pipelines.size());
+
+    return profile->pipelines.data();
+}
+
+void photog_profile_destroy(PhotogProfile *profile) {
+    delete profile;
+}
+
+void photog_profile_reset(void) {
+#ifdef PHOTOG_PROFILE
+    // Halide requires that no pipeline is running, as documented in color.h.
+    halide_profiler_reset();
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef PHOTOG_RAW_FORMAT_H
+#define PHOTOG_RAW_FORMAT_H
+
+#include <cstdint>
+
+namespace photog {
+    /** Identifies photog's raw format.*/
+    inline constexpr char raw_magic[8]{'P', 'H', 'O', 'T', 'O', 'G', 'R', 'W'};
+
+    /** Written in native byte order so that readers can detect files from
+     * hosts of the other byte order.*/
+    inline constexpr uint32_t raw_byte_order_mark{0x01020304};
+
+    /** Header of photog's raw format, read and written by photog::io and
+     * photog_chromadapt_file. Pixels follow it in native byte order, tightly
+     * packed in the given layout. Its size keeps pixel data aligned for every
+     * element type.*/
+    struct RawHeader {
+        char magic[8];
+        uint32_t byte_order;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t type; // PhotogElementType
+        uint32_t layout; // PhotogLayout
+        char reserved[32];
+    };
+
+    static_assert(sizeof(RawHeader) == 64,
+                  "photog's raw header must be 64 bytes.");
+}
+
+#endif // PHOTOG_RAW_FORMAT_H
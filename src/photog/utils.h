@@ -2,6 +2,7 @@
 #define PHOTOG_PHOTOG_UTILS_H
 
 #include <array>
+#include <cstddef>
 #include <iostream>
 #include <map>
 #include <string>
@@ -10,7 +11,7 @@
 #include "doctest/doctest.h"
 #include "Halide.h"
 
-#include "constants.h"
+#include "photog/color.h"
 
 namespace photog {
     template<typename T>
@@ -140,16 +141,13 @@ namespace photog {
         return output;
     }
 
-    photog::Layout get_layout();
-
     template<typename T>
     Halide::Runtime::Buffer<T>
-    get_buffer(T *data, int width, int height, int channels) {
-        photog::Layout layout = photog::get_layout();
-
-        if (layout == Layout::Planar)
+    get_buffer(T *data, int width, int height, int channels,
+               PhotogLayout layout) {
+        if (layout == PhotogLayout::Planar)
             return Halide::Runtime::Buffer<T>{data, {width, height, channels}};
-        else if (layout == Layout::Interleaved)
+        else if (layout == PhotogLayout::Interleaved)
             return Halide::Runtime::Buffer<T>::make_interleaved(data, width,
                                                                 height,
                                                                 channels);
@@ -159,6 +157,61 @@ namespace photog {
             abort();
         }
     }
+
+    /** Channel count of a described image, including any alpha channel.*/
+    inline int get_channels(const PhotogImage &image) {
+        return image.alpha == PhotogAlpha::Opaque ? 3 : 4;
+    }
+
+    /** Wraps the region of interest of a described image without copying.*/
+    template<typename T>
+    Halide::Runtime::Buffer<T>
+    get_buffer(const PhotogImage &image) {
+        const int channels = photog::get_channels(image);
+        halide_dimension_t shape[3]{{0, image.extent[0], image.stride[0]},
+                                    {0, image.extent[1], image.stride[1]},
+                                    {0, channels,        image.stride[2]}};
+        T *origin = static_cast<T *>(image.data) +
+                    static_cast<ptrdiff_t>(image.offset[0]) * image.stride[0] +
+                    static_cast<ptrdiff_t>(image.offset[1]) * image.stride[1];
+
+        return Halide::Runtime::Buffer<T>{origin, 3, shape};
+    }
+
+    /** Layout of a described image, deduced from its strides.*/
+    inline PhotogLayout get_layout(const PhotogImage &image) {
+        if (image.stride[0] == 1)
+            return PhotogLayout::Planar;
+        else if (image.stride[0] == photog::get_channels(image) &&
+                 image.stride[2] == 1)
+            return PhotogLayout::Interleaved;
+        else {
+            std::cerr << "Unsupported image strides (" << image.stride[0]
+                      << ", " << image.stride[1] << ", " << image.stride[2]
+                      << ") in photog::get_layout()." << std::endl;
+            abort();
+        }
+    }
+
+    /** Layout shared by an input and output image pair.
+     *
+     * Generated libraries expect both images to share an element type,
+     * layout, alpha channel and region size.*/
+    inline PhotogLayout
+    get_layout(const PhotogImage &input, const PhotogImage &output) {
+        PhotogLayout layout = photog::get_layout(input);
+
+        if (input.type != output.type || input.alpha != output.alpha ||
+            layout != photog::get_layout(output) ||
+            input.extent[0] != output.extent[0] ||
+            input.extent[1] != output.extent[1]) {
+            std::cerr << "Mismatched input and output images in "
+                      << "photog::get_layout()." << std::endl;
+            abort();
+        }
+
+        return layout;
+    }
 }
 
 TEST_CASE ("testing mul_33_by_31") {
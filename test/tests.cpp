@@ -1,17 +1,35 @@
 # define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#ifdef PHOTOG_FORK
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "doctest/doctest.h"
 #include "Halide.h"
 #include "halide_image_io.h"
 
 #include "photog/color.h"
+#ifdef PHOTOG_IO
+#include "photog/io.h"
+#endif
+#include "color_libraries.h"
 #include "color_utils.h"
+#include "raw_format.h"
 #include "utils.h"
 // Available after a CMake build
 #include "photog_srgb_to_linear.h"
+#include "photog_srgb_to_linear_fast.h"
 #include "photog_rgb_to_linear.h"
 #include "photog_srgb_to_xyz.h"
 #include "photog_rgb_to_xyz.h"
@@ -20,18 +38,21 @@
 #include "photog_xyz_to_srgb.h"
 #include "photog_xyz_to_rgb.h"
 #include "photog_average.h"
+#include "photog_illuminant_statistics.h"
+#include "photog_chromadapt_impl.h"
+#include "photog_chromadapt_folded_impl.h"
 
 namespace photog {
     template<typename T>
-    Halide::Runtime::Buffer<T> load_image(const std::string &image_path) {
-        photog::Layout layout = photog::get_layout();
-
+    Halide::Runtime::Buffer<T>
+    load_image(const std::string &image_path,
+               PhotogLayout layout = PhotogLayout::Planar) {
         Halide::Runtime::Buffer<T> image =
                 Halide::Tools::load_and_convert_image(image_path);
 
-        if (layout == Layout::Planar)
+        if (layout == PhotogLayout::Planar)
             return image;
-        else if (layout == Layout::Interleaved)
+        else if (layout == PhotogLayout::Interleaved)
             return image.copy_to_interleaved();
         else {
             std::cerr << "Unsupported image layout " << static_cast<int>(layout)
@@ -41,12 +62,12 @@ namespace photog {
     }
 
     template<typename T>
-    Halide::Runtime::Buffer<T> get_buffer(int width, int height, int channels) {
-        photog::Layout layout = photog::get_layout();
-
-        if (layout == Layout::Planar)
+    Halide::Runtime::Buffer<T>
+    get_buffer(int width, int height, int channels,
+               PhotogLayout layout = PhotogLayout::Planar) {
+        if (layout == PhotogLayout::Planar)
             return Halide::Runtime::Buffer<T>{width, height, channels};
-        else if (layout == Layout::Interleaved)
+        else if (layout == PhotogLayout::Interleaved)
             return Halide::Runtime::Buffer<T>::make_interleaved(width,
                                                                 height,
                                                                 channels);
@@ -56,6 +77,26 @@ namespace photog {
             abort();
         }
     }
+
+#ifdef PHOTOG_FORK
+    /** Whether calling a function aborts. The function runs in a child
+     * process, so that these tests keep running.*/
+    template<typename Function>
+    bool aborts(Function function) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Keeps the expected error message out of test output.
+            std::cerr.setstate(std::ios::failbit);
+            function();
+            _exit(0);
+        }
+
+        int status{0};
+        waitpid(pid, &status, 0);
+
+        return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    }
+#endif
 }
 
 // TODO: Refactor tests to get rid of common code.
@@ -80,6 +121,26 @@ TEST_CASE ("testing photog_srgb_to_linear") {
     CHECK(output(1824, 445, 2) == doctest::Approx(0.002428f));
 }
 
+TEST_CASE ("testing photog_srgb_to_linear_fast") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_srgb_to_linear_fast(input, output);
+
+    // 0.04045f < input(x, y, c)
+    CHECK(output(0, 0, 0) == doctest::Approx(0.423268f));
+    CHECK(output(0, 0, 1) == doctest::Approx(0.341914f));
+    CHECK(output(0, 0, 2) == doctest::Approx(0.194618f));
+    // input(x, y, c) <= 0.04045f
+    CHECK(output(1824, 445, 0) == doctest::Approx(0.003035f));
+    CHECK(output(1824, 445, 1) == doctest::Approx(0.003035f));
+    CHECK(output(1824, 445, 2) == doctest::Approx(0.002428f));
+}
+
 TEST_CASE ("testing photog_chromadapt") {
     std::string image_path = R"(images/rgb.jpg)";
     Halide::Runtime::Buffer<float> input =
@@ -89,13 +150,241 @@ TEST_CASE ("testing photog_chromadapt") {
                                       input.channels());
     Halide::Runtime::Buffer<float> source_tristimulus(3);
 
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+
+    Halide::Tools::convert_and_save_image(output, R"(images/out.jpg)");
+
+    // The original signature uses the configured layout and exact accuracy.
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> legacy =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::IMAGE_LAYOUT,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
     photog_chromadapt(input.data(), input.width(), input.height(),
                       PhotogWorkingSpace::Srgb,
                       PhotogChromadaptMethod::Bradford,
                       PhotogIlluminant::D50,
-                      output.data());
+                      legacy.data());
 
-    Halide::Tools::convert_and_save_image(output, R"(images/out.jpg)");
+    CHECK(legacy(0, 0, 0) == expected(0, 0, 0));
+    CHECK(legacy(0, 0, 1) == expected(0, 0, 1));
+    CHECK(legacy(0, 0, 2) == expected(0, 0, 2));
+    CHECK(legacy(1824, 445, 0) == expected(1824, 445, 0));
+    CHECK(legacy(1824, 445, 1) == expected(1824, 445, 1));
+    CHECK(legacy(1824, 445, 2) == expected(1824, 445, 2));
+}
+
+TEST_CASE ("testing photog_chromadapt_interleaved") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> input_interleaved =
+            photog::load_image<float>(image_path, PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels(),
+                                      PhotogLayout::Interleaved);
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    photog_chromadapt_ex(input_interleaved.data(), input_interleaved.width(),
+                         input_interleaved.height(),
+                         PhotogLayout::Interleaved,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+
+    CHECK(output(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+    CHECK(output(0, 0, 1) == doctest::Approx(expected(0, 0, 1)));
+    CHECK(output(0, 0, 2) == doctest::Approx(expected(0, 0, 2)));
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+    CHECK(output(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+    CHECK(output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+}
+
+TEST_CASE ("testing photog_chromadapt_u8") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<uint8_t> input_u8 =
+            photog::load_image<uint8_t>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<uint8_t> output =
+            photog::get_buffer<uint8_t>(input.width(), input.height(),
+                                        input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    photog_chromadapt_u8(input_u8.data(), input_u8.width(), input_u8.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+
+    // Quantized output is within one step of the float pipeline's output.
+    for (int c = 0; c < 3; ++c) {
+        CHECK(std::abs(output(0, 0, c) - expected(0, 0, c) * 255.0f) <= 1.0f);
+        CHECK(std::abs(output(1824, 445, c) -
+                       expected(1824, 445, c) * 255.0f) <= 1.0f);
+    }
+}
+
+TEST_CASE ("testing photog_chromadapt_f16") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<Halide::float16_t> input_f16 =
+            photog::get_buffer<Halide::float16_t>(input.width(),
+                                                  input.height(),
+                                                  input.channels());
+    input_f16.for_each_element([&](int x, int y, int c) {
+        input_f16(x, y, c) = Halide::float16_t{input(x, y, c)};
+    });
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<Halide::float16_t> output =
+            photog::get_buffer<Halide::float16_t>(input.width(),
+                                                  input.height(),
+                                                  input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    photog_chromadapt_f16(reinterpret_cast<uint16_t *>(input_f16.data()),
+                          input.width(), input.height(),
+                          PhotogLayout::Planar,
+                          PhotogWorkingSpace::Srgb,
+                          PhotogChromadaptMethod::Bradford,
+                          PhotogIlluminant::D50,
+                          PhotogAccuracy::Exact,
+                          reinterpret_cast<uint16_t *>(output.data()));
+
+    // Half-precision elements hold 11 significant bits.
+    for (int c = 0; c < 3; ++c) {
+        CHECK(std::abs(static_cast<float>(output(0, 0, c)) -
+                       expected(0, 0, c)) <= 2e-3f);
+        CHECK(std::abs(static_cast<float>(output(1824, 445, c)) -
+                       expected(1824, 445, c)) <= 2e-3f);
+    }
+}
+
+TEST_CASE ("testing photog_chromadapt_fused") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    // Sampling every pixel gives the same estimate as photog_chromadapt.
+    int result = photog_chromadapt_fused(input.data(), input.width(),
+                                         input.height(), PhotogLayout::Planar,
+                                         1, PhotogWorkingSpace::Srgb,
+                                         PhotogChromadaptMethod::Bradford,
+                                         PhotogIlluminant::D50,
+                                         PhotogAccuracy::Exact,
+                                         output.data());
+
+    CHECK(result == 0);
+
+    CHECK(output(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+    CHECK(output(0, 0, 1) == doctest::Approx(expected(0, 0, 1)));
+    CHECK(output(0, 0, 2) == doctest::Approx(expected(0, 0, 2)));
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+    CHECK(output(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+    CHECK(output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+
+    PhotogImage input_image =
+            photog_make_image(input.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar);
+    PhotogImage output_image =
+            photog_make_image(output.data(), Float32, output.width(),
+                              output.height(), PhotogLayout::Planar);
+    result = photog_chromadapt_fused_image(&input_image, 1,
+                                           PhotogWorkingSpace::Srgb,
+                                           PhotogChromadaptMethod::Bradford,
+                                           PhotogIlluminant::D50,
+                                           PhotogAccuracy::Exact,
+                                           &output_image);
+
+    CHECK(result == 0);
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+
+#ifdef PHOTOG_FORK
+    // Factors below 1 sample no pixels.
+    for (int sample_factor : {0, -1}) {
+        CHECK(photog::aborts([&]() {
+            photog_chromadapt_fused(input.data(), input.width(),
+                                    input.height(), PhotogLayout::Planar,
+                                    sample_factor, PhotogWorkingSpace::Srgb,
+                                    PhotogChromadaptMethod::Bradford,
+                                    PhotogIlluminant::D50,
+                                    PhotogAccuracy::Exact, output.data());
+        }));
+        CHECK(photog::aborts([&]() {
+            photog_chromadapt_fused_image(&input_image, sample_factor,
+                                          PhotogWorkingSpace::Srgb,
+                                          PhotogChromadaptMethod::Bradford,
+                                          PhotogIlluminant::D50,
+                                          PhotogAccuracy::Exact,
+                                          &output_image);
+        }));
+    }
+#endif
 }
 
 TEST_CASE ("testing photog_chromadapt_diy") {
@@ -117,17 +406,760 @@ TEST_CASE ("testing photog_chromadapt_diy") {
                                photog::get_rgb_to_xyz_xfmr(
                                        PhotogWorkingSpace::Srgb));
 
-    photog_chromadapt_diy(input.data(), input.width(), input.height(),
-                          source_tristimulus.data(),
-                          PhotogWorkingSpace::Srgb,
-                          PhotogChromadaptMethod::Bradford,
-                          photog::get_tristimulus(
-                                  PhotogIlluminant::D50).data(),
-                          output.data());
+    photog_chromadapt_diy_ex(input.data(), input.width(), input.height(),
+                             PhotogLayout::Planar,
+                             source_tristimulus.data(),
+                             PhotogWorkingSpace::Srgb,
+                             PhotogChromadaptMethod::Bradford,
+                             photog::get_tristimulus(
+                                     PhotogIlluminant::D50).data(),
+                             PhotogAccuracy::Exact,
+                             output.data());
 
     Halide::Tools::convert_and_save_image(output, R"(images/out.jpg)");
 }
 
+TEST_CASE ("testing photog_chromadapt_image") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    // Rows padded as a pooled allocator would.
+    const int padding = 16;
+    Halide::Runtime::Buffer<float> padded_input =
+            photog::get_buffer<float>(input.width() + padding, input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> padded_output =
+            photog::get_buffer<float>(input.width() + padding, input.height(),
+                                      input.channels());
+    padded_input.cropped(0, 0, input.width()).copy_from(input);
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    PhotogImage in =
+            photog_crop_image(photog_make_image(padded_input.data(), Float32,
+                                                padded_input.width(),
+                                                padded_input.height(),
+                                                PhotogLayout::Planar),
+                              0, 0, input.width(), input.height());
+    PhotogImage out =
+            photog_crop_image(photog_make_image(padded_output.data(), Float32,
+                                                padded_output.width(),
+                                                padded_output.height(),
+                                                PhotogLayout::Planar),
+                              0, 0, input.width(), input.height());
+
+    photog_chromadapt_image(&in,
+                            PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D50,
+                            PhotogAccuracy::Exact,
+                            &out);
+
+    CHECK(padded_output(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+    CHECK(padded_output(0, 0, 1) == doctest::Approx(expected(0, 0, 1)));
+    CHECK(padded_output(0, 0, 2) == doctest::Approx(expected(0, 0, 2)));
+    CHECK(padded_output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+    CHECK(padded_output(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+    CHECK(padded_output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+
+    // Regions at an offset are adapted without touching their surroundings.
+    const int margin = 8;
+    Halide::Runtime::Buffer<float> framed_input =
+            photog::get_buffer<float>(input.width() + 2 * margin,
+                                      input.height() + 2 * margin,
+                                      input.channels());
+    Halide::Runtime::Buffer<float> framed_output =
+            photog::get_buffer<float>(input.width() + 2 * margin,
+                                      input.height() + 2 * margin,
+                                      input.channels());
+    framed_input.fill(0.5f);
+    framed_input.cropped(0, margin, input.width())
+            .cropped(1, margin, input.height())
+            .translated({-margin, -margin})
+            .copy_from(input);
+    framed_output.fill(-1.0f);
+    in = photog_crop_image(photog_make_image(framed_input.data(), Float32,
+                                             framed_input.width(),
+                                             framed_input.height(),
+                                             PhotogLayout::Planar),
+                           margin, margin, input.width(), input.height());
+    out = photog_crop_image(photog_make_image(framed_output.data(), Float32,
+                                              framed_output.width(),
+                                              framed_output.height(),
+                                              PhotogLayout::Planar),
+                            margin, margin, input.width(), input.height());
+
+    photog_chromadapt_image(&in,
+                            PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D50,
+                            PhotogAccuracy::Exact,
+                            &out);
+
+    const int right = margin + input.width(), bottom = margin + input.height();
+    for (int c = 0; c < 3; ++c) {
+        CHECK(framed_output(margin, margin, c) ==
+              doctest::Approx(expected(0, 0, c)));
+        CHECK(framed_output(margin + 1824, margin + 445, c) ==
+              doctest::Approx(expected(1824, 445, c)));
+        CHECK(framed_output(margin - 1, margin, c) == -1.0f);
+        CHECK(framed_output(margin, margin - 1, c) == -1.0f);
+        CHECK(framed_output(right, bottom - 1, c) == -1.0f);
+        CHECK(framed_output(right - 1, bottom, c) == -1.0f);
+    }
+
+#ifdef PHOTOG_FORK
+    // Regions must lie within the image.
+    const std::array<int, 4> regions[]{
+            {-1, 0, input.width(), input.height()},
+            {0, -1, input.width(), input.height()},
+            {1, 0, input.width(), input.height()},
+            {0, 1, input.width(), input.height()},
+            {0, 0, 0, input.height()},
+            {0, 0, input.width(), 0}};
+    PhotogImage image =
+            photog_make_image(input.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar);
+    for (const std::array<int, 4> &region : regions)
+        CHECK(photog::aborts([&]() {
+            photog_crop_image(image, region[0], region[1], region[2],
+                              region[3]);
+        }));
+#endif
+}
+
+TEST_CASE ("testing photog images with alpha") {
+    std::string image_path = R"(images/rgb.jpg)";
+    const float alpha = 0.5f;
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path, PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels(),
+                                      PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> straight =
+            photog::get_buffer<float>(input.width(), input.height(), 4,
+                                      PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> premultiplied =
+            photog::get_buffer<float>(input.width(), input.height(), 4,
+                                      PhotogLayout::Interleaved);
+    straight.for_each_element([&](int x, int y, int c) {
+        straight(x, y, c) = c < 3 ? input(x, y, c) : alpha;
+        premultiplied(x, y, c) = c < 3 ? input(x, y, c) * alpha : alpha;
+    });
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Interleaved,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    for (PhotogAlpha image_alpha : {PhotogAlpha::Straight,
+                                    PhotogAlpha::Premultiplied}) {
+        Halide::Runtime::Buffer<float> &rgba =
+                image_alpha == PhotogAlpha::Straight ? straight : premultiplied;
+        PhotogImage image =
+                photog_make_image_with_alpha(rgba.data(), Float32,
+                                             rgba.width(), rgba.height(),
+                                             PhotogLayout::Interleaved,
+                                             image_alpha);
+
+        // Adapted in place, so alpha is left as it is.
+        photog_chromadapt_image(&image,
+                                PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                PhotogIlluminant::D50,
+                                PhotogAccuracy::Exact,
+                                &image);
+
+        float scale = image_alpha == PhotogAlpha::Straight ? 1.0f : alpha;
+        for (int c = 0; c < 3; ++c) {
+            CHECK(rgba(0, 0, c) ==
+                  doctest::Approx(expected(0, 0, c) * scale));
+            CHECK(rgba(1824, 445, c) ==
+                  doctest::Approx(expected(1824, 445, c) * scale));
+        }
+        CHECK(rgba(0, 0, 3) == alpha);
+        CHECK(rgba(1824, 445, 3) == alpha);
+    }
+
+    // Alpha of integer images is copied without conversion.
+    Halide::Runtime::Buffer<uint8_t> rgba_u8 =
+            photog::get_buffer<uint8_t>(2, 1, 4, PhotogLayout::Interleaved);
+    rgba_u8.fill(128);
+    rgba_u8(1, 0, 3) = 7;
+    PhotogImage image_u8 =
+            photog_make_image_with_alpha(rgba_u8.data(), Uint8, 2, 1,
+                                         PhotogLayout::Interleaved,
+                                         PhotogAlpha::Straight);
+
+    photog_srgb_to_linear_in_place(&image_u8, PhotogAccuracy::Exact);
+
+    CHECK(rgba_u8(0, 0, 0) == 55);
+    CHECK(rgba_u8(0, 0, 3) == 128);
+    CHECK(rgba_u8(1, 0, 3) == 7);
+
+#ifdef PHOTOG_FORK
+    // Variants with alpha are only built for interleaved images.
+    Halide::Runtime::Buffer<uint8_t> planar_u8 =
+            photog::get_buffer<uint8_t>(2, 1, 4, PhotogLayout::Planar);
+    PhotogImage planar_image =
+            photog_make_image_with_alpha(planar_u8.data(), Uint8, 2, 1,
+                                         PhotogLayout::Planar,
+                                         PhotogAlpha::Straight);
+    CHECK(photog::aborts([&]() {
+        photog_srgb_to_linear_in_place(&planar_image, PhotogAccuracy::Exact);
+    }));
+#endif
+}
+
+TEST_CASE ("testing photog_chromadapt_diy_image") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    std::array<float, 3> source_tristimulus =
+            photog::get_tristimulus(PhotogIlluminant::A);
+    std::array<float, 3> dest_tristimulus =
+            photog::get_tristimulus(PhotogIlluminant::D50);
+
+    photog_chromadapt_diy_ex(input.data(), input.width(), input.height(),
+                             PhotogLayout::Planar,
+                             source_tristimulus.data(),
+                             PhotogWorkingSpace::Srgb,
+                             PhotogChromadaptMethod::Bradford,
+                             dest_tristimulus.data(),
+                             PhotogAccuracy::Exact,
+                             expected.data());
+
+    // Only the region of interest is adapted.
+    const int x = 1800, y = 400, width = 100, height = 100;
+    PhotogImage in =
+            photog_crop_image(photog_make_image(input.data(), Float32,
+                                                input.width(), input.height(),
+                                                PhotogLayout::Planar),
+                              x, y, width, height);
+    PhotogImage out =
+            photog_crop_image(photog_make_image(output.data(), Float32,
+                                                output.width(), output.height(),
+                                                PhotogLayout::Planar),
+                              x, y, width, height);
+    output.fill(-1.0f);
+
+    photog_chromadapt_diy_image(&in,
+                                source_tristimulus.data(),
+                                PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                dest_tristimulus.data(),
+                                PhotogAccuracy::Exact,
+                                &out);
+
+    CHECK(output(0, 0, 0) == -1.0f);
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+    CHECK(output(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+    CHECK(output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+}
+
+TEST_CASE ("testing photog_chromadapt_batch") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> expected_crop =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output_crop =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    // Images of different sizes in one batch.
+    PhotogImage full =
+            photog_make_image(input.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar);
+    PhotogImage crop = photog_crop_image(full, 1800, 400, 500, 300);
+    PhotogImage inputs[]{full, crop};
+    PhotogImage expected_images[]{
+            photog_make_image(expected.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar),
+            photog_crop_image(
+                    photog_make_image(expected_crop.data(), Float32,
+                                      input.width(), input.height(),
+                                      PhotogLayout::Planar),
+                    1800, 400, 500, 300)};
+    PhotogImage outputs[]{
+            photog_make_image(output.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar),
+            photog_crop_image(
+                    photog_make_image(output_crop.data(), Float32,
+                                      input.width(), input.height(),
+                                      PhotogLayout::Planar),
+                    1800, 400, 500, 300)};
+
+    for (int i = 0; i < 2; ++i)
+        photog_chromadapt_image(&inputs[i],
+                                PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                PhotogIlluminant::D50,
+                                PhotogAccuracy::Exact,
+                                &expected_images[i]);
+
+    int result = photog_chromadapt_batch(inputs, 2,
+                                         PhotogWorkingSpace::Srgb,
+                                         PhotogChromadaptMethod::Bradford,
+                                         PhotogIlluminant::D50,
+                                         PhotogAccuracy::Exact,
+                                         outputs);
+
+    CHECK(result == 0);
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+        CHECK(output_crop(1824, 445, c) ==
+              doctest::Approx(expected_crop(1824, 445, c)));
+    }
+}
+
+TEST_CASE ("testing photog_chromadapt_plan") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    PhotogChromadaptPlan *plan =
+            photog_chromadapt_plan_create(PhotogWorkingSpace::Srgb,
+                                          PhotogChromadaptMethod::Bradford,
+                                          PhotogIlluminant::D50,
+                                          PhotogAccuracy::Exact);
+    PhotogImage in = photog_make_image(input.data(), Float32, input.width(),
+                                       input.height(), PhotogLayout::Planar);
+    PhotogImage out = photog_make_image(output.data(), Float32,
+                                        output.width(), output.height(),
+                                        PhotogLayout::Planar);
+    // Plans are reusable.
+    CHECK(photog_chromadapt_plan_execute(plan, &in, &out) == 0);
+    CHECK(photog_chromadapt_plan_execute(plan, &in, &out) == 0);
+    photog_chromadapt_plan_destroy(plan);
+
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+    }
+}
+
+TEST_CASE ("testing photog_video_session") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    PhotogVideoSession *session =
+            photog_video_session_create(PhotogWorkingSpace::Srgb,
+                                        PhotogChromadaptMethod::Bradford,
+                                        PhotogIlluminant::D50,
+                                        PhotogAccuracy::Exact, 0.25f, 1.0f);
+    PhotogImage in = photog_make_image(input.data(), Float32, input.width(),
+                                       input.height(), PhotogLayout::Planar);
+    PhotogImage out = photog_make_image(output.data(), Float32,
+                                        output.width(), output.height(),
+                                        PhotogLayout::Planar);
+    PhotogVideoReport report{};
+
+    // A still scene: estimates coarsen from every pixel to every 16th pixel
+    // of every 16th row, then run on every 4th frame.
+    for (int frame = 0; frame < 10; ++frame)
+        photog_video_session_process(session, &in, &out);
+    photog_video_session_report(session, &report);
+
+    CHECK(report.frames == 10);
+    CHECK(report.estimated_frames == 6);
+    CHECK(report.sample_factor == 16);
+    CHECK(report.transform_updates == 1);
+    // The transform is still the one built from the first, full estimate.
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+    }
+
+    // A scene change: the next estimate reads every pixel again and moves
+    // the smoothed estimate far enough to rebuild the transform.
+    for (int y = 0; y < input.height(); ++y)
+        for (int x = 0; x < input.width(); ++x)
+            input(x, y, 0) *= 0.5f;
+    for (int frame = 0; frame < 3; ++frame)
+        photog_video_session_process(session, &in, &out);
+    photog_video_session_report(session, &report);
+    photog_video_session_destroy(session);
+
+    CHECK(report.frames == 13);
+    CHECK(report.estimated_frames == 7);
+    CHECK(report.sample_factor == 1);
+    CHECK(report.transform_updates == 2);
+}
+
+TEST_CASE ("testing photog jit backend") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    std::filesystem::path cache_dir =
+            std::filesystem::temp_directory_path() / "photog_tests_cache";
+    std::filesystem::remove_all(cache_dir);
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    photog_set_cache_dir(cache_dir.c_str());
+    PhotogBackend previous = photog_set_backend(PhotogBackend::Jit);
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+    // Similar sizes share the pipeline's schedule.
+    PhotogImage in = photog_crop_image(
+            photog_make_image(input.data(), Float32, input.width(),
+                              input.height(), PhotogLayout::Planar),
+            0, 0, input.width() - 1, input.height() - 1);
+    Halide::Runtime::Buffer<float> cropped =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    PhotogImage out = photog_crop_image(
+            photog_make_image(cropped.data(), Float32, cropped.width(),
+                              cropped.height(), PhotogLayout::Planar),
+            0, 0, cropped.width() - 1, cropped.height() - 1);
+    photog_chromadapt_image(&in, PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D50, PhotogAccuracy::Exact,
+                            &out);
+    photog_set_backend(previous);
+    photog_set_cache_dir(nullptr);
+
+    // The pipeline's schedule is cached for later processes.
+    int cached{0};
+    for (const auto &entry : std::filesystem::directory_iterator{cache_dir})
+        cached += entry.path().extension() == ".hlpipe";
+    CHECK(cached == 1);
+
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+    }
+}
+
+namespace {
+    /** Images streamed to and from photog_chromadapt_stream.*/
+    struct StreamedImages {
+        Halide::Runtime::Buffer<float> input;
+        Halide::Runtime::Buffer<float> output;
+    };
+
+    int read_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *images = static_cast<StreamedImages *>(user_context);
+        Halide::Runtime::Buffer<float> buffer =
+                photog::get_buffer<float>(*strip);
+        buffer.translate(1, y);
+        buffer.copy_from(images->input);
+
+        return 0;
+    }
+
+    int write_strip(void *user_context, int y, const PhotogImage *strip) {
+        auto *images = static_cast<StreamedImages *>(user_context);
+        Halide::Runtime::Buffer<float> buffer =
+                photog::get_buffer<float>(*strip);
+        buffer.translate(1, y);
+        images->output.copy_from(buffer);
+
+        return 0;
+    }
+}
+
+TEST_CASE ("testing photog_chromadapt_stream") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    StreamedImages images{input,
+                          photog::get_buffer<float>(input.width(),
+                                                    input.height(),
+                                                    input.channels())};
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    // The last strip is shorter than the others.
+    int result = photog_chromadapt_stream(read_strip, write_strip, &images,
+                                          input.width(), input.height(),
+                                          Float32, PhotogLayout::Planar, 100,
+                                          PhotogWorkingSpace::Srgb,
+                                          PhotogChromadaptMethod::Bradford,
+                                          PhotogIlluminant::D50,
+                                          PhotogAccuracy::Exact);
+
+    CHECK(result == 0);
+    for (int c = 0; c < 3; ++c) {
+        CHECK(images.output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(images.output(1824, 445, c) ==
+              doctest::Approx(expected(1824, 445, c)));
+        CHECK(images.output(0, input.height() - 1, c) ==
+              doctest::Approx(expected(0, input.height() - 1, c)));
+    }
+}
+
+TEST_CASE ("testing photog_chromadapt_file") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path, PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels(),
+                                      PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels(),
+                                      PhotogLayout::Interleaved);
+    std::filesystem::path input_path =
+            std::filesystem::temp_directory_path() / "photog_input.raw";
+    std::filesystem::path output_path =
+            std::filesystem::temp_directory_path() / "photog_output.raw";
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Interleaved,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    photog::RawHeader header{};
+    std::memcpy(header.magic, photog::raw_magic, sizeof(photog::raw_magic));
+    header.byte_order = photog::raw_byte_order_mark;
+    header.width = static_cast<uint32_t>(input.width());
+    header.height = static_cast<uint32_t>(input.height());
+    header.channels = 3;
+    header.type = Float32;
+    header.layout = PhotogLayout::Interleaved;
+    {
+        std::ofstream file{input_path, std::ios::binary};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(input.data()),
+                   static_cast<std::streamsize>(input.size_in_bytes()));
+    }
+    int result = photog_chromadapt_file(input_path.c_str(),
+                                        output_path.c_str(), 256,
+                                        PhotogWorkingSpace::Srgb,
+                                        PhotogChromadaptMethod::Bradford,
+                                        PhotogIlluminant::D50,
+                                        PhotogAccuracy::Exact);
+    photog::RawHeader output_header{};
+    {
+        std::ifstream file{output_path, std::ios::binary};
+        file.read(reinterpret_cast<char *>(&output_header),
+                  sizeof(output_header));
+        file.read(reinterpret_cast<char *>(output.data()),
+                  static_cast<std::streamsize>(output.size_in_bytes()));
+    }
+
+    CHECK(result == 0);
+    CHECK(std::memcmp(&output_header, &header, sizeof(header)) == 0);
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+    }
+}
+
+#ifdef PHOTOG_IO
+TEST_CASE ("testing photog::io") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path, PhotogLayout::Interleaved);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels(),
+                                      PhotogLayout::Interleaved);
+    std::string pfm_path =
+            (std::filesystem::temp_directory_path() / "photog_io.pfm").string();
+    std::string raw_path =
+            (std::filesystem::temp_directory_path() / "photog_io.raw").string();
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Interleaved,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    {
+        photog::io::MappedImage pfm = photog::io::MappedImage::create(
+                pfm_path, photog::io::Format::Pfm, Float32, input.width(),
+                input.height(), input.channels());
+        pfm.buffer<float>().copy_from(input);
+    }
+
+    // Images are adapted in place within a private mapping of the file.
+    photog::io::MappedImage pfm = photog::io::MappedImage::open(pfm_path);
+    photog::io::MappedImage raw = photog::io::MappedImage::create(
+            raw_path, photog::io::Format::Raw, Float32, input.width(),
+            input.height(), input.channels(), PhotogLayout::Planar);
+    PhotogImage pfm_image = pfm.image();
+    PhotogImage raw_image = raw.image();
+    photog_chromadapt_image(&pfm_image,
+                            PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D50,
+                            PhotogAccuracy::Exact,
+                            &pfm_image);
+    raw.buffer<float>().copy_from(pfm.buffer<float>());
+
+    CHECK(pfm.format() == photog::io::Format::Pfm);
+    CHECK(pfm.width() == input.width());
+    CHECK(pfm.height() == input.height());
+    Halide::Runtime::Buffer<float> output = raw.buffer<float>();
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(expected(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(expected(1824, 445, c)));
+    }
+}
+#endif
+
+namespace {
+    int par_for_calls{0};
+
+    /** Runs tasks serially, counting each parallel loop it is given.*/
+    int counting_do_par_for(void *user_context, PhotogTask task, int min,
+                            int size, uint8_t *closure) {
+        ++par_for_calls;
+        for (int x = min; x < min + size; ++x) {
+            int result = task(user_context, x, closure);
+            if (result != 0)
+                return result;
+        }
+
+        return 0;
+    }
+}
+
+TEST_CASE ("testing photog parallelism") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         expected.data());
+
+    // Work runs on a custom scheduler when one is installed.
+    PhotogDoParFor previous =
+            photog_set_custom_do_par_for(counting_do_par_for);
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+    photog_set_custom_do_par_for(previous);
+
+    CHECK(par_for_calls > 0);
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+
+    // Serial calls stay on the calling thread and skip the scheduler.
+    photog_set_custom_do_par_for(counting_do_par_for);
+    par_for_calls = 0;
+    PhotogParallelism parallelism =
+            photog_set_thread_parallelism(PhotogParallelism::Serial);
+    photog_chromadapt_ex(input.data(), input.width(), input.height(),
+                         PhotogLayout::Planar,
+                         PhotogWorkingSpace::Srgb,
+                         PhotogChromadaptMethod::Bradford,
+                         PhotogIlluminant::D50,
+                         PhotogAccuracy::Exact,
+                         output.data());
+    photog_set_thread_parallelism(parallelism);
+    photog_set_custom_do_par_for(previous);
+
+    CHECK(par_for_calls == 0);
+    CHECK(output(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+    CHECK(output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+}
+
 TEST_CASE ("testing photog_rgb_to_linear") {
     std::string image_path = R"(images/rgb.jpg)";
     Halide::Runtime::Buffer<float> input =
@@ -305,6 +1337,105 @@ TEST_CASE ("testing photog_xyz_to_rgb") {
     CHECK(output(4550, 711, 2) == doctest::Approx(input(4550, 711, 2)));
 }
 
+TEST_CASE ("testing photog color space conversions in place") {
+    std::string image_path = R"(images/rgb.jpg)";
+
+    for (PhotogLayout layout : {PhotogLayout::Planar,
+                                PhotogLayout::Interleaved}) {
+        Halide::Runtime::Buffer<float> input =
+                photog::load_image<float>(image_path, layout);
+        Halide::Runtime::Buffer<float> expected =
+                photog::get_buffer<float>(input.width(), input.height(),
+                                          input.channels(), layout);
+        Halide::Runtime::Buffer<float> image = input.copy();
+
+        PhotogImage in = photog_make_image(input.data(), Float32,
+                                           input.width(), input.height(),
+                                           layout);
+        PhotogImage out = photog_make_image(expected.data(), Float32,
+                                            input.width(), input.height(),
+                                            layout);
+        PhotogImage in_place = photog_make_image(image.data(), Float32,
+                                                 input.width(),
+                                                 input.height(), layout);
+
+        // Each XYZ channel reads every RGB channel of its pixel.
+        photog_rgb_to_xyz_image(&in, PhotogWorkingSpace::Srgb,
+                                PhotogAccuracy::Exact, &out);
+        photog_rgb_to_xyz_in_place(&in_place, PhotogWorkingSpace::Srgb,
+                                   PhotogAccuracy::Exact);
+
+        CHECK(image(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+        CHECK(image(0, 0, 1) == doctest::Approx(expected(0, 0, 1)));
+        CHECK(image(0, 0, 2) == doctest::Approx(expected(0, 0, 2)));
+        CHECK(image(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+        CHECK(image(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+        CHECK(image(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+
+        photog_xyz_to_rgb_in_place(&in_place, PhotogWorkingSpace::Srgb,
+                                   PhotogAccuracy::Exact);
+        photog_rgb_to_linear_in_place(&in_place, PhotogWorkingSpace::Srgb,
+                                      PhotogAccuracy::Exact);
+        photog_linear_to_srgb_in_place(&in_place, PhotogAccuracy::Exact);
+        photog_srgb_to_xyz_in_place(&in_place, PhotogAccuracy::Exact);
+        photog_xyz_to_srgb_in_place(&in_place, PhotogAccuracy::Exact);
+        photog_srgb_to_linear_in_place(&in_place, PhotogAccuracy::Exact);
+        photog_linear_to_rgb_in_place(&in_place, PhotogWorkingSpace::Srgb,
+                                      PhotogAccuracy::Exact);
+
+        // Round trips through every conversion return the input.
+        CHECK(image(0, 0, 0) == doctest::Approx(input(0, 0, 0)));
+        CHECK(image(0, 0, 1) == doctest::Approx(input(0, 0, 1)));
+        CHECK(image(0, 0, 2) == doctest::Approx(input(0, 0, 2)));
+        CHECK(image(4550, 711, 0) == doctest::Approx(input(4550, 711, 0)));
+        CHECK(image(4550, 711, 1) == doctest::Approx(input(4550, 711, 1)));
+        CHECK(image(4550, 711, 2) == doctest::Approx(input(4550, 711, 2)));
+    }
+}
+
+TEST_CASE ("testing photog integer XYZ round trips") {
+    const int width{8}, height{4};
+
+    // White has a Z of about 1.09, which fits integer XYZ images once scaled.
+    auto round_trip = [&](auto element, PhotogElementType type) {
+        using T = decltype(element);
+        const int max_value{std::numeric_limits<T>::max()};
+        Halide::Runtime::Buffer<T> white(width, height, 3);
+        Halide::Runtime::Buffer<T> xyz(width, height, 3);
+        Halide::Runtime::Buffer<T> output(width, height, 3);
+        white.fill(static_cast<T>(max_value));
+        PhotogImage white_image =
+                photog_make_image(white.data(), type, width, height,
+                                  PhotogLayout::Planar);
+        PhotogImage xyz_image = photog_make_image(xyz.data(), type, width,
+                                                  height,
+                                                  PhotogLayout::Planar);
+        PhotogImage output_image =
+                photog_make_image(output.data(), type, width, height,
+                                  PhotogLayout::Planar);
+
+        photog_srgb_to_xyz_image(&white_image, PhotogAccuracy::Exact,
+                                 &xyz_image);
+        CHECK(static_cast<int>(xyz(0, 0, 2)) < max_value);
+        photog_xyz_to_srgb_image(&xyz_image, PhotogAccuracy::Exact,
+                                 &output_image);
+        // 8-bit XYZ values are a little coarser than 8-bit sRGB ones.
+        for (int c = 0; c < 3; ++c)
+            CHECK(max_value - static_cast<int>(output(3, 2, c)) <= 1);
+
+        photog_rgb_to_xyz_image(&white_image, PhotogWorkingSpace::Srgb,
+                                PhotogAccuracy::Exact, &xyz_image);
+        CHECK(static_cast<int>(xyz(0, 0, 2)) < max_value);
+        photog_xyz_to_rgb_image(&xyz_image, PhotogWorkingSpace::Srgb,
+                                PhotogAccuracy::Exact, &output_image);
+        for (int c = 0; c < 3; ++c)
+            CHECK(max_value - static_cast<int>(output(3, 2, c)) <= 1);
+    };
+
+    round_trip(uint8_t{}, Uint8);
+    round_trip(uint16_t{}, Uint16);
+}
+
 TEST_CASE ("testing photog_average") {
     // TODO: Add test for 64-bit input.
     std::string image_path = R"(images/rgb.jpg)";
@@ -347,3 +1478,402 @@ TEST_CASE ("testing photog_average") {
     CHECK(averages[1] == doctest::Approx(output(1)));
     CHECK(averages[2] == doctest::Approx(output(2)));
 }
+
+TEST_CASE ("testing photog_illuminant_statistics") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> output{3, 3};
+    const float norm{6.0f};
+
+    photog_illuminant_statistics(input, norm, output);
+
+    const int width = input.width(), height = input.height();
+    for (int c = 0; c < 3; ++c) {
+        double max{0}, power_sum{0}, edge_sum{0};
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                double value = input(x, y, c);
+                double dx = input(std::min(x + 1, width - 1), y, c) - value;
+                double dy = input(x, std::min(y + 1, height - 1), c) - value;
+                max = std::max(max, value);
+                power_sum += std::pow(value, norm);
+                edge_sum += std::pow(std::sqrt(dx * dx + dy * dy), norm);
+            }
+        }
+        // Normalized by color elements, as photog_average is.
+        double count = static_cast<double>(width) * height * 3;
+
+        CHECK(output(c, 0) == doctest::Approx(max));
+        CHECK(output(c, 1) ==
+              doctest::Approx(std::pow(power_sum / count, 1 / norm)));
+        CHECK(output(c, 2) ==
+              doctest::Approx(std::pow(edge_sum / count, 1 / norm)));
+    }
+
+    // Shades-of-gray with a norm of 1 is gray-world.
+    Halide::Runtime::Buffer<float> gray_world{3};
+    photog_average(input, gray_world);
+    photog_illuminant_statistics(input, 1.0f, output);
+    for (int c = 0; c < 3; ++c)
+        CHECK(output(c, 1) == doctest::Approx(gray_world(c)));
+
+    // Gray-world estimates match photog_chromadapt_image's.
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(width, height, 3);
+    Halide::Runtime::Buffer<float> estimated =
+            photog::get_buffer<float>(width, height, 3);
+    PhotogImage in = photog_make_image(input.data(), Float32, width, height,
+                                       PhotogLayout::Planar);
+    PhotogImage expected_out = photog_make_image(expected.data(), Float32,
+                                                 width, height,
+                                                 PhotogLayout::Planar);
+    PhotogImage estimated_out = photog_make_image(estimated.data(), Float32,
+                                                  width, height,
+                                                  PhotogLayout::Planar);
+
+    photog_chromadapt_image(&in, PhotogWorkingSpace::Srgb,
+                            PhotogChromadaptMethod::Bradford,
+                            PhotogIlluminant::D50, PhotogAccuracy::Exact,
+                            &expected_out);
+    photog_chromadapt_estimator_image(&in, PhotogIlluminantEstimator::GrayWorld,
+                                      PhotogWorkingSpace::Srgb,
+                                      PhotogChromadaptMethod::Bradford,
+                                      PhotogIlluminant::D50,
+                                      PhotogAccuracy::Exact, &estimated_out);
+
+    CHECK(estimated(1824, 445, 0) == expected(1824, 445, 0));
+    CHECK(estimated(1824, 445, 2) == expected(1824, 445, 2));
+
+    // White-patch estimates are the working space's XYZ of each channel's
+    // maximum.
+    std::array<float, 3> tristimulus{};
+    photog_estimate_illuminant(&in, PhotogIlluminantEstimator::WhitePatch,
+                               PhotogWorkingSpace::Srgb, tristimulus.data());
+    float white_patch_rgb[3]{output(0, 0), output(1, 0), output(2, 0)};
+    Halide::Runtime::Buffer<float> white_patch_xyz = photog::rgb_to_xyz(
+            photog::copy_to_buffer(white_patch_rgb),
+            photog::get_gamma(PhotogWorkingSpace::Srgb),
+            photog::get_rgb_to_xyz_xfmr(PhotogWorkingSpace::Srgb));
+    for (int c = 0; c < 3; ++c)
+        CHECK(tristimulus[c] == doctest::Approx(white_patch_xyz(c)));
+}
+
+TEST_CASE ("testing photog_estimate_illuminant_sampled") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    PhotogImage image = photog_make_image(input.data(), Float32, input.width(),
+                                          input.height(),
+                                          PhotogLayout::Planar);
+    std::array<float, 3> full{}, sampled{};
+    PhotogSamplingReport report{};
+
+    photog_estimate_illuminant(&image, PhotogIlluminantEstimator::GrayWorld,
+                               PhotogWorkingSpace::Srgb, full.data());
+
+    // A factor of 1 reads every pixel.
+    photog_estimate_illuminant_sampled(&image, 1, PhotogWorkingSpace::Srgb,
+                                       sampled.data(), &report);
+
+    for (int c = 0; c < 3; ++c)
+        CHECK(sampled[c] == doctest::Approx(full[c]));
+    CHECK(report.sampled_fraction == 1.0f);
+    CHECK(report.angular_error == doctest::Approx(0.0f).epsilon(1e-3));
+
+    photog_estimate_illuminant_sampled(&image, 8, PhotogWorkingSpace::Srgb,
+                                       sampled.data(), &report);
+
+    CHECK(report.sampled_fraction == doctest::Approx(1.0f / 64).epsilon(0.01));
+    CHECK(report.angular_error < 0.5f);
+    for (int c = 0; c < 3; ++c)
+        CHECK(sampled[c] == doctest::Approx(full[c]).epsilon(0.02));
+
+    // Reports are optional.
+    photog_estimate_illuminant_sampled(&image, 8, PhotogWorkingSpace::Srgb,
+                                       sampled.data(), nullptr);
+
+#ifdef PHOTOG_FORK
+    // Factors below 1 sample no pixels.
+    for (int sample_factor : {0, -1}) {
+        CHECK(photog::aborts([&]() {
+            photog_estimate_illuminant_sampled(&image, sample_factor,
+                                               PhotogWorkingSpace::Srgb,
+                                               sampled.data(), nullptr);
+        }));
+        CHECK(photog::aborts([&]() {
+            photog_chromadapt_sampled_image(&image, sample_factor,
+                                            PhotogWorkingSpace::Srgb,
+                                            PhotogChromadaptMethod::Bradford,
+                                            PhotogIlluminant::D65,
+                                            PhotogAccuracy::Exact, &image);
+        }));
+    }
+#endif
+}
+
+TEST_CASE ("testing photog_image_statistics") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<uint8_t> input =
+            photog::load_image<uint8_t>(image_path, PhotogLayout::Interleaved);
+    const int bins{PHOTOG_HISTOGRAM_BINS};
+    PhotogImage image = photog_make_image(input.data(), Uint8, input.width(),
+                                          input.height(),
+                                          PhotogLayout::Interleaved);
+    PhotogImageStatistics statistics{};
+
+    photog_image_statistics(&image, &statistics);
+
+    // Reference: a serial pass over the image. 8-bit values sit well inside
+    // their bins, so bins match exactly.
+    for (int c = 0; c < 3; ++c) {
+        std::array<uint32_t, bins> histogram{};
+        uint32_t clipped_low{0}, clipped_high{0};
+        int min{255}, max{0};
+        for (int y = 0; y < input.height(); ++y) {
+            for (int x = 0; x < input.width(); ++x) {
+                int value = input(x, y, c);
+                ++histogram[std::min(value * bins / 255, bins - 1)];
+                clipped_low += value == 0;
+                clipped_high += value == 255;
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+        }
+
+        for (int b = 0; b < bins; ++b)
+            CHECK(statistics.histogram[c][b] == histogram[b]);
+        CHECK(statistics.clipped_low[c] == clipped_low);
+        CHECK(statistics.clipped_high[c] == clipped_high);
+        CHECK(statistics.min[c] == doctest::Approx(min / 255.0f));
+        CHECK(statistics.max[c] == doctest::Approx(max / 255.0f));
+        CHECK(photog_statistics_percentile(&statistics, c, 0.0f) ==
+              statistics.min[c]);
+        CHECK(photog_statistics_percentile(&statistics, c, 100.0f) ==
+              statistics.max[c]);
+    }
+
+    float median = photog_statistics_percentile(&statistics, 1, 50.0f);
+    CHECK(median >= statistics.min[1]);
+    CHECK(median <= statistics.max[1]);
+}
+
+TEST_CASE ("testing photog_lut_apply") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    PhotogImage in = photog_make_image(input.data(), Float32, input.width(),
+                                       input.height(), PhotogLayout::Planar);
+    PhotogImage exp = photog_make_image(expected.data(), Float32,
+                                        expected.width(), expected.height(),
+                                        PhotogLayout::Planar);
+    PhotogImage out = photog_make_image(output.data(), Float32,
+                                        output.width(), output.height(),
+                                        PhotogLayout::Planar);
+
+    // Tetrahedral interpolation reproduces linear transforms exactly.
+    PhotogLut *identity = photog_lut_bake(
+            2, [](void *, const PhotogImage *grid, const PhotogImage *baked) {
+                photog_srgb_to_linear_image(grid, baked,
+                                            PhotogAccuracy::Exact);
+                photog_linear_to_srgb_in_place(baked, PhotogAccuracy::Exact);
+            }, nullptr);
+    photog_lut_apply(identity, &in, &out);
+    photog_lut_destroy(identity);
+
+    for (int c = 0; c < 3; ++c) {
+        CHECK(output(0, 0, c) == doctest::Approx(input(0, 0, c)));
+        CHECK(output(1824, 445, c) == doctest::Approx(input(1824, 445, c)));
+    }
+
+    // Errors of a baked chromatic adaptation stay bounded.
+    std::array<float, 3> source = photog::get_tristimulus(PhotogIlluminant::A);
+    photog_chromadapt_diy_image(&in, source.data(), PhotogWorkingSpace::Srgb,
+                                PhotogChromadaptMethod::Bradford,
+                                photog::get_tristimulus(
+                                        PhotogIlluminant::D65).data(),
+                                PhotogAccuracy::Exact, &exp);
+
+    PhotogLut *adapt = photog_lut_bake(
+            33, [](void *user_context, const PhotogImage *grid,
+                   const PhotogImage *baked) {
+                auto source = static_cast<float *>(user_context);
+                std::array<float, 3> dest =
+                        photog::get_tristimulus(PhotogIlluminant::D65);
+                photog_chromadapt_diy_image(grid, source,
+                                            PhotogWorkingSpace::Srgb,
+                                            PhotogChromadaptMethod::Bradford,
+                                            dest.data(),
+                                            PhotogAccuracy::Exact, baked);
+            }, source.data());
+    photog_lut_apply(adapt, &in, &out);
+    photog_lut_destroy(adapt);
+
+    double total_error{0};
+    float max_error{0};
+    for (int c = 0; c < 3; ++c) {
+        for (int y = 0; y < input.height(); ++y) {
+            for (int x = 0; x < input.width(); ++x) {
+                float error = std::abs(output(x, y, c) - expected(x, y, c));
+                total_error += error;
+                max_error = std::max(max_error, error);
+            }
+        }
+    }
+    CHECK(max_error < 0.02f);
+    CHECK(total_error / (3.0 * input.width() * input.height()) < 1e-3);
+}
+
+TEST_CASE ("testing photog::get_size_bucket") {
+    const double small = static_cast<double>(SMALL_X_EXTENT_ESTIMATE) *
+                         SMALL_Y_EXTENT_ESTIMATE;
+    const double medium = static_cast<double>(X_EXTENT_ESTIMATE) *
+                          Y_EXTENT_ESTIMATE;
+    const double huge = static_cast<double>(HUGE_X_EXTENT_ESTIMATE) *
+                        HUGE_Y_EXTENT_ESTIMATE;
+    // Buckets change at the geometric means of neighbouring estimates.
+    const int lower = static_cast<int>(std::ceil(std::sqrt(small * medium)));
+    const int upper = static_cast<int>(std::ceil(std::sqrt(medium * huge)));
+
+    CHECK(photog::get_size_bucket(1, 1) == photog::Small);
+    CHECK(photog::get_size_bucket(SMALL_X_EXTENT_ESTIMATE,
+                                  SMALL_Y_EXTENT_ESTIMATE) == photog::Small);
+    CHECK(photog::get_size_bucket(lower - 1, 1) == photog::Small);
+    CHECK(photog::get_size_bucket(lower, 1) == photog::Medium);
+    CHECK(photog::get_size_bucket(X_EXTENT_ESTIMATE, Y_EXTENT_ESTIMATE) ==
+          photog::Medium);
+    CHECK(photog::get_size_bucket(upper - 1, 1) == photog::Medium);
+    CHECK(photog::get_size_bucket(upper, 1) == photog::Huge);
+    CHECK(photog::get_size_bucket(HUGE_X_EXTENT_ESTIMATE,
+                                  HUGE_Y_EXTENT_ESTIMATE) == photog::Huge);
+
+    // Images with alpha use medium variants at every size. Libraries are
+    // compared as booleans, since doctest cannot print function pointers.
+    for (photog::SizeBucket size : {photog::Small, photog::Medium,
+                                    photog::Huge}) {
+        bool medium_variant =
+                photog::ColorLibraries<float>::chromadapt_folded_impl(
+                        PhotogAlpha::Straight, PhotogLayout::Interleaved,
+                        size, PhotogAccuracy::Exact) ==
+                &photog_chromadapt_folded_impl_interleaved_rgba;
+        CHECK(medium_variant);
+    }
+    bool small_variant =
+            photog::ColorLibraries<float>::chromadapt_folded_impl(
+                    PhotogAlpha::Opaque, PhotogLayout::Planar, photog::Small,
+                    PhotogAccuracy::Exact) ==
+            &photog_chromadapt_folded_impl_small;
+    bool huge_variant =
+            photog::ColorLibraries<float>::chromadapt_folded_impl(
+                    PhotogAlpha::Opaque, PhotogLayout::Planar, photog::Huge,
+                    PhotogAccuracy::Exact) ==
+            &photog_chromadapt_folded_impl_huge;
+    CHECK(small_variant);
+    CHECK(huge_variant);
+}
+
+TEST_CASE ("testing photog_chromadapt_folded_impl") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> expected =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> source_tristimulus =
+            photog::copy_to_buffer(
+                    photog::get_tristimulus(PhotogIlluminant::A));
+    Halide::Runtime::Buffer<float> dest_tristimulus =
+            photog::copy_to_buffer(
+                    photog::get_tristimulus(PhotogIlluminant::D65));
+    float gamma = photog::get_gamma(PhotogWorkingSpace::Srgb);
+
+    photog_chromadapt_impl(input, gamma,
+                           photog::get_rgb_to_xyz_xfmr(
+                                   PhotogWorkingSpace::Srgb),
+                           photog::get_xyz_to_rgb_xfmr(
+                                   PhotogWorkingSpace::Srgb),
+                           photog::create_transform(
+                                   PhotogChromadaptMethod::Bradford,
+                                   source_tristimulus, dest_tristimulus),
+                           expected);
+
+    photog_chromadapt_folded_impl(input, gamma,
+                                  photog::create_rgb_transform(
+                                          PhotogWorkingSpace::Srgb,
+                                          PhotogChromadaptMethod::Bradford,
+                                          source_tristimulus,
+                                          dest_tristimulus),
+                                  output);
+
+    CHECK(output(0, 0, 0) == doctest::Approx(expected(0, 0, 0)));
+    CHECK(output(0, 0, 1) == doctest::Approx(expected(0, 0, 1)));
+    CHECK(output(0, 0, 2) == doctest::Approx(expected(0, 0, 2)));
+    CHECK(output(1824, 445, 0) == doctest::Approx(expected(1824, 445, 0)));
+    CHECK(output(1824, 445, 1) == doctest::Approx(expected(1824, 445, 1)));
+    CHECK(output(1824, 445, 2) == doctest::Approx(expected(1824, 445, 2)));
+}
+
+TEST_CASE ("testing photog profiling") {
+    std::string image_path = R"(images/rgb.jpg)";
+    Halide::Runtime::Buffer<float> input =
+            photog::load_image<float>(image_path);
+    Halide::Runtime::Buffer<float> output =
+            photog::get_buffer<float>(input.width(), input.height(),
+                                      input.channels());
+    Halide::Runtime::Buffer<float> source_tristimulus =
+            photog::copy_to_buffer(
+                    photog::get_tristimulus(PhotogIlluminant::A));
+    Halide::Runtime::Buffer<float> dest_tristimulus =
+            photog::copy_to_buffer(
+                    photog::get_tristimulus(PhotogIlluminant::D65));
+
+    photog_profile_reset();
+    photog_chromadapt_impl(input, photog::get_gamma(PhotogWorkingSpace::Srgb),
+                           photog::get_rgb_to_xyz_xfmr(
+                                   PhotogWorkingSpace::Srgb),
+                           photog::get_xyz_to_rgb_xfmr(
+                                   PhotogWorkingSpace::Srgb),
+                           photog::create_transform(
+                                   PhotogChromadaptMethod::Bradford,
+                                   source_tristimulus, dest_tristimulus),
+                           output);
+
+    PhotogProfile *profile = photog_profile_capture();
+    int count{0};
+    const PhotogPipelineProfile *pipelines =
+            photog_profile_pipelines(profile, &count);
+
+    if (!photog_profiling_enabled()) {
+        CHECK(count == 0);
+    } else {
+        // Libraries built for several targets are named after the target
+        // that ran, so names are matched by prefix.
+        const PhotogPipelineProfile *impl{nullptr};
+        for (int i = 0; i < count; ++i)
+            if (std::string(pipelines[i].name).rfind(
+                    "photog_chromadapt_impl", 0) == 0)
+                impl = &pipelines[i];
+
+        REQUIRE(impl != nullptr);
+        CHECK(impl->runs == 1);
+        CHECK(impl->seconds >= 0.0);
+        CHECK(impl->stage_count > 0);
+        double stage_seconds{0};
+        for (int i = 0; i < impl->stage_count; ++i) {
+            CHECK(impl->stages[i].name != nullptr);
+            CHECK(impl->stages[i].thread_utilization >= 0.0f);
+            stage_seconds += impl->stages[i].seconds;
+        }
+        CHECK(stage_seconds == doctest::Approx(impl->seconds).epsilon(0.01));
+    }
+    photog_profile_destroy(profile);
+}